@@ -22,6 +22,9 @@ if (!(Test-Path -Path "build")) {
 Write-Host "Configurando proyecto con CMake..."
 cmake -DCMAKE_BUILD_TYPE=$config `
       -DOpenCV_DIR="$opencv_path/x64/mingw/lib" `
+      -DGLAD_DIR="$glad_path" `
+      -DGLFW_DIR="$glfw_path" `
+      -DGLM_INCLUDE_DIR="$glm_path" `
       -G "MinGW Makefiles" `
       -B build
 
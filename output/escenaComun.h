@@ -0,0 +1,481 @@
+#pragma once
+// Código común a los visores que dibujan todas las partes desde buffers de
+// escena compartidos (organo, visualTodo, viTeta): rangos de glMultiDraw*,
+// bloque uniforme de partes, selección de partes con el teclado y la afín
+// de cada parte a la caja global (que también usa visualDefinitivo), el
+// corte en bloques, el frustum culling y la carga en paralelo.
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mallaComun.h"
+
+// ==================== Estructuras ====================
+struct Range {
+    double minX, maxX, minY, maxY, minZ, maxZ;
+};
+
+struct AABB { glm::vec3 min, max; };
+
+// Tramo contiguo de una parte, con rangos relativos a la parte
+struct Bloque {
+    size_t firstPoint, pointCount;
+    size_t firstLine, lineCount;
+    AABB caja;
+};
+
+inline AABB cajaVacia() { return {glm::vec3(1e30f), glm::vec3(-1e30f)}; }
+
+inline void expandir(AABB& c, const Point& p) {
+    glm::vec3 v((float)p.x, (float)p.y, (float)p.z);
+    c.min = glm::min(c.min, v);
+    c.max = glm::max(c.max, v);
+}
+
+// ==================== Frustum culling ====================
+// Cada parte se corta en bloques de TAM_BLOQUE puntos contiguos con su caja.
+// Para que los bloques sean compactos, los puntos se reordenan por código
+// Morton (también en las partes de un solo bloque) y cada arista pasa al
+// bloque de su vértice menor. Cada cuadro se descartan las partes y bloques
+// cuya caja queda fuera del frustum.
+const size_t TAM_BLOQUE = 16384;
+
+inline glm::vec4 planosFrustum[6];
+
+// Reordena `points`, traduce `lineIndices` y `otrosIndices` (cualquier otro
+// arreglo de índices a `points`) y arma `bloques`; `caja` queda con la caja
+// de toda la parte. Las aristas quedan ordenadas por su vértice menor.
+inline void construirBloques(std::vector<Point>& points, std::vector<GLuint>& lineIndices,
+                             std::initializer_list<std::vector<GLuint>*> otrosIndices,
+                             AABB& caja, std::vector<Bloque>& bloques) {
+    size_t n = points.size();
+    bloques.clear();
+    caja = cajaVacia();
+    for (const auto& p : points) expandir(caja, p);
+    if (n == 0) return;
+
+    // Orden Morton de los puntos
+    glm::vec3 ext = glm::max(caja.max - caja.min, glm::vec3(1e-9f));
+    std::vector<std::pair<uint32_t, GLuint>> codigos(n);
+    #pragma omp parallel for
+    for (size_t i = 0; i < n; ++i) {
+        const Point& p = points[i];
+        glm::vec3 q = (glm::vec3((float)p.x, (float)p.y, (float)p.z) - caja.min) / ext * 1023.0f;
+        codigos[i] = {(expandirBits((uint32_t)q.x) << 2) | (expandirBits((uint32_t)q.y) << 1) | expandirBits((uint32_t)q.z), (GLuint)i};
+    }
+    std::sort(codigos.begin(), codigos.end());
+
+    std::vector<Point> ordenados(n);
+    std::vector<GLuint> nuevoIndice(n);
+    for (size_t i = 0; i < n; ++i) {
+        ordenados[i] = points[codigos[i].second];
+        nuevoIndice[codigos[i].second] = i;
+    }
+    points.swap(ordenados);
+    for (auto* indices : otrosIndices)
+        for (auto& v : *indices) v = nuevoIndice[v];
+
+    // Aristas reasignadas y ordenadas por su vértice menor
+    std::vector<std::pair<GLuint, GLuint>> aristas(lineIndices.size() / 2);
+    for (size_t e = 0; e < aristas.size(); ++e) {
+        GLuint a = nuevoIndice[lineIndices[e * 2]], b = nuevoIndice[lineIndices[e * 2 + 1]];
+        aristas[e] = {std::min(a, b), std::max(a, b)};
+    }
+    std::sort(aristas.begin(), aristas.end());
+    for (size_t e = 0; e < aristas.size(); ++e) {
+        lineIndices[e * 2] = aristas[e].first;
+        lineIndices[e * 2 + 1] = aristas[e].second;
+    }
+
+    size_t e = 0;
+    for (size_t ini = 0; ini < n; ini += TAM_BLOQUE) {
+        Bloque b{ini, std::min(TAM_BLOQUE, n - ini), e * 2, 0, cajaVacia()};
+        for (size_t i = b.firstPoint; i < b.firstPoint + b.pointCount; ++i) expandir(b.caja, points[i]);
+        for (; e < aristas.size() && aristas[e].first < b.firstPoint + b.pointCount; ++e)
+            expandir(b.caja, points[aristas[e].second]);
+        b.lineCount = e * 2 - b.firstLine;
+        bloques.push_back(b);
+    }
+}
+
+// Planos de Gribb-Hartmann a partir de projection * view * model
+inline void extraerPlanosFrustum(const glm::mat4& m) {
+    glm::vec4 fila[4];
+    for (int i = 0; i < 4; ++i) fila[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    for (int i = 0; i < 3; ++i) {
+        planosFrustum[i * 2] = fila[3] + fila[i];
+        planosFrustum[i * 2 + 1] = fila[3] - fila[i];
+    }
+}
+
+// `c` está en coordenadas de la parte; `escala`/`desplazamiento` la llevan a
+// la caja global (ver "Normalización global")
+inline bool cajaVisible(const AABB& c, const glm::vec3& escala, const glm::vec3& desplazamiento) {
+    glm::vec3 mn = c.min * escala + desplazamiento;
+    glm::vec3 mx = c.max * escala + desplazamiento;
+    for (const auto& pl : planosFrustum) {
+        glm::vec3 p(pl.x >= 0 ? mx.x : mn.x, pl.y >= 0 ? mx.y : mn.y, pl.z >= 0 ? mx.z : mn.z);
+        if (pl.x * p.x + pl.y * p.y + pl.z * p.z + pl.w < 0) return false;
+    }
+    return true;
+}
+
+// ==================== Normalización global ====================
+// Los .bin vienen normalizados por órgano a [-1, 1]. En vez de desnormalizar
+// y renormalizar cada vértice, se compone por parte la afín
+//   desnormalizar: p * (max - min) / 2 + (max + min) / 2
+//   normalizar:    (p - gMin) / (gMax - gMin) * 2 - 1
+// que queda en part.escala / part.desplazamiento; cada visor la aplica en
+// el shader. La caja global es la unión de los rangos originales, así que
+// no hace falta recorrer ningún vértice.
+template <class Parte>
+void normalizarGlobal(std::vector<Parte>& partes) {
+    double gMinX = 1e9, gMaxX = -1e9;
+    double gMinY = 1e9, gMaxY = -1e9;
+    double gMinZ = 1e9, gMaxZ = -1e9;
+
+    for (const auto& part : partes) {
+        const Range& r = part.rango;
+        gMinX = std::min(gMinX, r.minX); gMaxX = std::max(gMaxX, r.maxX);
+        gMinY = std::min(gMinY, r.minY); gMaxY = std::max(gMaxY, r.maxY);
+        gMinZ = std::min(gMinZ, r.minZ); gMaxZ = std::max(gMaxZ, r.maxZ);
+    }
+
+    auto eje = [](double mn, double mx, double gMn, double gMx, float& escala, float& desp) {
+        double s = 2.0 / (gMx - gMn);
+        escala = (float)((mx - mn) / 2.0 * s);
+        desp = (float)(((mx + mn) / 2.0 - gMn) * s - 1.0);
+    };
+
+    for (auto& part : partes) {
+        const Range& r = part.rango;
+        eje(r.minX, r.maxX, gMinX, gMaxX, part.escala.x, part.desplazamiento.x);
+        eje(r.minY, r.maxY, gMinY, gMaxY, part.escala.y, part.desplazamiento.y);
+        eje(r.minZ, r.maxZ, gMinZ, gMaxZ, part.escala.z, part.desplazamiento.z);
+    }
+}
+
+// ==================== Buffers de escena ====================
+// Un único VAO/VBO/EBO para todas las partes: cada parte sólo guarda su
+// rango, y los rangos de las partes visibles alimentan glMultiDraw*. Los
+// índices de aristas son locales a la parte; el base vertex los desplaza.
+const size_t MAX_PARTES = 256;
+
+// Vértice sin cuantizar de VBO_scene; `parte` indexa el bloque uniforme
+struct Vertice { float x, y, z; GLuint parte; };
+
+// Un tramo que empieza donde terminó el anterior se fusiona con él;
+// cortarTramos() evita que se fusionen tramos de partes distintas.
+struct RangosDibujo {
+    std::vector<GLint> pointFirsts;
+    std::vector<GLsizei> pointCounts;
+    std::vector<GLsizei> lineCounts;
+    std::vector<const void*> lineOffsets;
+    std::vector<GLint> lineBaseVertex;
+    size_t finPuntos = SIZE_MAX, finAristas = SIZE_MAX;
+
+    void limpiar() {
+        pointFirsts.clear(); pointCounts.clear();
+        lineOffsets.clear(); lineCounts.clear(); lineBaseVertex.clear();
+        cortarTramos();
+    }
+
+    void cortarTramos() { finPuntos = finAristas = SIZE_MAX; }
+
+    void agregarPuntos(size_t first, size_t count) {
+        if (count == 0) return;
+        if (first == finPuntos) pointCounts.back() += count;
+        else { pointFirsts.push_back((GLint)first); pointCounts.push_back((GLsizei)count); }
+        finPuntos = first + count;
+    }
+
+    // `firstLine` en índices de EBO_scene (no en bytes)
+    void agregarAristas(size_t firstLine, size_t count, size_t baseVertex) {
+        if (count == 0) return;
+        if (firstLine == finAristas && (GLint)baseVertex == lineBaseVertex.back()) lineCounts.back() += count;
+        else {
+            lineOffsets.push_back((const void*)(firstLine * sizeof(GLuint)));
+            lineCounts.push_back((GLsizei)count);
+            lineBaseVertex.push_back((GLint)baseVertex);
+        }
+        finAristas = firstLine + count;
+    }
+};
+
+struct ConteoDibujo {
+    size_t puntosDibujados, puntosDescartados;
+    size_t aristasDibujadas, aristasDescartadas;
+};
+
+// Agrega los bloques de una parte cuya caja pasa `visible` (AABB en
+// coordenadas de la parte -> bool); con `parteVisible` en falso se
+// descartan todos sin probarlos.
+template <class Visible>
+void agregarBloquesVisibles(const std::vector<Bloque>& bloques, size_t firstPoint, size_t firstLine,
+                            bool parteVisible, Visible visible, RangosDibujo& rangos, ConteoDibujo& conteo) {
+    for (const auto& b : bloques) {
+        if (!parteVisible || !visible(b.caja)) {
+            conteo.puntosDescartados += b.pointCount;
+            conteo.aristasDescartadas += b.lineCount / 2;
+            continue;
+        }
+        conteo.puntosDibujados += b.pointCount;
+        conteo.aristasDibujadas += b.lineCount / 2;
+        rangos.agregarPuntos(firstPoint + b.firstPoint, b.pointCount);
+        rangos.agregarAristas(firstLine + b.firstLine, b.lineCount, firstPoint);
+    }
+}
+
+// VAO de escena y bloque uniforme `bloque` (binding 0) de `bytes` bytes,
+// todavía sin datos. Los buffers de vértices arrancan vacíos y crecen a
+// medida que llegan las partes.
+inline void crearEscena(size_t nPartes, GLuint programa, const char* bloque, size_t bytes, GLuint& vao, GLuint& ubo) {
+    if (nPartes > MAX_PARTES) throw std::runtime_error(std::string("Demasiadas partes para el bloque ") + bloque);
+
+    glGenVertexArrays(1, &vao);
+
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, bytes, nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, ubo);
+    glUniformBlockBinding(programa, glGetUniformBlockIndex(programa, bloque), 0);
+}
+
+// ==================== Selección de partes ====================
+// Flechas: elegir parte, espacio: mostrar/ocultar, 0: mostrar todas.
+// `seleccionada` es -1 hasta que se elige una. Devuelve true si cambió la
+// visibilidad de alguna parte.
+template <class Parte>
+bool teclaPartes(int key, std::vector<Parte>& partes, int& seleccionada) {
+    int n = partes.size();
+    if (n == 0) return false;
+    if (key == GLFW_KEY_UP || key == GLFW_KEY_DOWN) {
+        if (seleccionada < 0) seleccionada = key == GLFW_KEY_UP ? 0 : n - 1;
+        else seleccionada = (seleccionada + (key == GLFW_KEY_UP ? 1 : n - 1)) % n;
+        std::cout << "Parte seleccionada: " << partes[seleccionada].nombre << "\n";
+    } else if (key == GLFW_KEY_SPACE) {
+        if (seleccionada < 0) return false;
+        auto& part = partes[seleccionada];
+        part.visible = !part.visible;
+        return true;
+    } else if (key == GLFW_KEY_0) {
+        for (auto& part : partes) part.visible = true;
+        return true;
+    }
+    return false;
+}
+
+// ==================== Carga en paralelo ====================
+// Un pool de hilos lee y empaqueta cada parte con la función `decodificar`
+// del visor; el hilo de GL sólo copia buffers ya armados, hasta
+// MAX_BYTES_SUBIDA por cuadro para que la ventana siga respondiendo. Las
+// partes entran a los buffers de escena en el orden en que terminan.
+const size_t MAX_BYTES_SUBIDA = 32u << 20;
+
+struct ParteLista {
+    size_t parte;
+    std::vector<unsigned char> vertices;   // En el formato de VBO_scene del visor
+    std::vector<GLuint> indices;           // Locales a la parte, para EBO_scene
+};
+
+// `points` como Vertice de la parte `parte`
+inline std::vector<unsigned char> empaquetarPuntos(const std::vector<Point>& points, size_t parte) {
+    std::vector<unsigned char> bytes(points.size() * sizeof(Vertice));
+    Vertice* v = reinterpret_cast<Vertice*>(bytes.data());
+    for (size_t j = 0; j < points.size(); ++j) {
+        const Point& p = points[j];
+        v[j] = {(float)p.x, (float)p.y, (float)p.z, (GLuint)parte};
+    }
+    return bytes;
+}
+
+class CargadorPartes {
+public:
+    // Corre en los hilos del cargador: lee `ruta` en la parte `parte` y llena
+    // `lista`. Si lanza, se llama a `descartar(parte)` y la parte llega vacía.
+    using Decodificar = std::function<void(size_t parte, const std::string& ruta, ParteLista& lista)>;
+    using Descartar = std::function<void(size_t parte)>;
+
+    std::ostream* log = &std::cout;
+
+    ~CargadorPartes() { detener(); }
+
+    // Pares (índice de la parte, ruta)
+    void iniciar(std::vector<std::pair<size_t, std::string>> nuevasRutas, Decodificar d, Descartar x) {
+        rutas = std::move(nuevasRutas);
+        decodificar = std::move(d);
+        descartar = std::move(x);
+        inicio = std::chrono::steady_clock::now();
+        size_t n = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), rutas.size());
+        for (size_t i = 0; i < n; ++i) hilos.emplace_back([this] { trabajar(); });
+    }
+
+    // `rutas[i]` es la ruta de la parte i
+    void iniciar(const std::vector<std::string>& rutas, Decodificar d, Descartar x) {
+        std::vector<std::pair<size_t, std::string>> pares;
+        for (size_t i = 0; i < rutas.size(); ++i) pares.emplace_back(i, rutas[i]);
+        iniciar(std::move(pares), std::move(d), std::move(x));
+    }
+
+    // Los hilos terminan la parte que están cargando y salen
+    void detener() {
+        cancelar = true;
+        for (auto& h : hilos) if (h.joinable()) h.join();
+        hilos.clear();
+    }
+
+    // Al menos una parte si hay alguna, y más mientras quepan en maxBytes
+    std::vector<ParteLista> tomarListas(size_t maxBytes) {
+        std::lock_guard<std::mutex> lock(m);
+        std::vector<ParteLista> r;
+        size_t bytes = 0;
+        while (!listas.empty()) {
+            size_t b = bytesDe(listas.front());
+            if (!r.empty() && bytes + b > maxBytes) break;
+            bytes += b;
+            r.push_back(std::move(listas.front()));
+            listas.pop_front();
+        }
+        return r;
+    }
+
+    bool hayListas() {
+        std::lock_guard<std::mutex> lock(m);
+        return !listas.empty();
+    }
+
+    // Quedan partes por cargar o por subir
+    bool pendientes() {
+        std::lock_guard<std::mutex> lock(m);
+        return terminadas < rutas.size() || !listas.empty();
+    }
+
+    // Bloquea hasta que haya una parte lista o no quede ninguna por venir
+    void esperar() {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] { return !listas.empty() || terminadas == rutas.size(); });
+    }
+
+    double msCarga() const { return msTotal; }
+
+private:
+    static size_t bytesDe(const ParteLista& l) {
+        return l.vertices.size() + l.indices.size() * sizeof(GLuint);
+    }
+
+    void trabajar() {
+        for (size_t k; !cancelar && (k = siguiente++) < rutas.size();) {
+            const auto& [i, ruta] = rutas[k];
+            ParteLista lista{i, {}, {}};
+            std::string error;
+            try {
+                decodificar(i, ruta, lista);
+            } catch (const std::exception& e) {
+                error = e.what();
+                descartar(i);
+                lista.vertices.clear();
+                lista.indices.clear();
+            }
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if (error.empty()) *log << "Cargado: " << ruta << "\n";
+                else std::cerr << "Error cargando " << ruta << ": " << error << "\n";
+                listas.push_back(std::move(lista));
+                if (++terminadas == rutas.size())
+                    msTotal = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inicio).count();
+            }
+            cv.notify_all();
+            glfwPostEmptyEvent(); // Despierta al render loop si está esperando eventos
+        }
+    }
+
+    std::vector<std::pair<size_t, std::string>> rutas;
+    Decodificar decodificar;
+    Descartar descartar;
+    std::vector<std::thread> hilos;
+    std::atomic<size_t> siguiente{0};
+    std::atomic<bool> cancelar{false};
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<ParteLista> listas;
+    size_t terminadas = 0;
+    std::chrono::steady_clock::time_point inicio;
+    double msTotal = 0.0;
+};
+
+// VBO_scene y EBO_scene arrancan vacíos y duplican su capacidad cuando una
+// parte no entra. Los visores sin aristas dejan `ebo` en 0.
+struct BuffersEscena {
+    GLuint vbo = 0, ebo = 0;
+    size_t puntos = 0, aristas = 0;                   // Elementos ocupados
+    size_t capacidadPuntos = 0, capacidadAristas = 0; // Elementos reservados
+};
+
+// Reemplaza `viejo` por un buffer de bytesNuevos con los primeros bytesUsados copiados en la GPU
+inline GLuint crecerBuffer(GLuint viejo, size_t bytesUsados, size_t bytesNuevos) {
+    GLuint nuevo;
+    glGenBuffers(1, &nuevo);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, nuevo);
+    glBufferData(GL_COPY_WRITE_BUFFER, bytesNuevos, nullptr, GL_STATIC_DRAW);
+    if (bytesUsados > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, viejo);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, bytesUsados);
+    }
+    if (viejo) glDeleteBuffers(1, &viejo);
+    return nuevo;
+}
+
+// Copia a los buffers de escena las partes que terminó el cargador, hasta
+// maxBytes. `ubicar(parte, firstPoint, firstLine)` registra dónde quedó
+// cada una y `enlazar()` rearma el VAO cuando se reemplaza algún buffer.
+// Devuelve cuántas partes subió.
+template <class Ubicar, class Enlazar>
+size_t subirPartesListas(CargadorPartes& cargador, BuffersEscena& escena, size_t tamVertice, size_t maxBytes,
+                         Ubicar ubicar, Enlazar enlazar) {
+    auto listas = cargador.tomarListas(maxBytes);
+    for (auto& l : listas) {
+        size_t nPuntos = l.vertices.size() / tamVertice, nIndices = l.indices.size();
+
+        bool crecio = false;
+        if (escena.puntos + nPuntos > escena.capacidadPuntos) {
+            size_t cap = std::max(escena.capacidadPuntos * 2, escena.puntos + nPuntos);
+            escena.vbo = crecerBuffer(escena.vbo, escena.puntos * tamVertice, cap * tamVertice);
+            escena.capacidadPuntos = cap;
+            crecio = true;
+        }
+        if (escena.aristas + nIndices > escena.capacidadAristas) {
+            size_t cap = std::max(escena.capacidadAristas * 2, escena.aristas + nIndices);
+            escena.ebo = crecerBuffer(escena.ebo, escena.aristas * sizeof(GLuint), cap * sizeof(GLuint));
+            escena.capacidadAristas = cap;
+            crecio = true;
+        }
+        if (crecio) enlazar();
+
+        // COPY_WRITE en vez de ELEMENT_ARRAY para no tocar el estado del VAO
+        glBindBuffer(GL_COPY_WRITE_BUFFER, escena.vbo);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, escena.puntos * tamVertice, l.vertices.size(), l.vertices.data());
+        if (nIndices > 0) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, escena.ebo);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, escena.aristas * sizeof(GLuint), nIndices * sizeof(GLuint), l.indices.data());
+        }
+
+        ubicar(l.parte, escena.puntos, escena.aristas);
+        escena.puntos += nPuntos;
+        escena.aristas += nIndices;
+    }
+    return listas.size();
+}
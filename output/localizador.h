@@ -0,0 +1,532 @@
+#pragma once
+// KD-tree estático y dinámico sobre Point, y el localizador de puntos en
+// una malla de tetraedros terminada. Los usa la triangulación de
+// test/kdSinstacing.cpp; test/verificarKdTree.cpp y
+// test/localizarTetraedros.cpp los comparan contra fuerza bruta. Sin glad,
+// como mallaComun.h.
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+#include <omp.h>
+
+#include "mallaComun.h"
+
+// ==================== KD-tree ====================
+// Árbol balanceado por mediana, armado en el lugar: los puntos se copian
+// una vez junto con su índice original y cada nodo parte su tramo con
+// nth_element, así que el arreglo queda con la permutación y cada hoja (a
+// lo sumo TAM_HOJA puntos) es un tramo contiguo. Los nodos van en orden de
+// heap (hijos 2i + 1 y 2i + 2) y cada tarea escribe los suyos sin
+// coordinar con las demás. Reconstruir reutiliza la memoria de la vez
+// anterior.
+//
+// Para las consultas las hojas se copian además como columnas x, y, z, de
+// modo que las distancias de una hoja entera salen de un bucle SIMD. Los
+// resultados son índices del vector que se pasó a build().
+class KDTree {
+private:
+    static const size_t TAM_HOJA = 16;
+    static const size_t MIN_TAREA = 32768;   // Tramos más chicos se arman en el hilo actual
+
+    struct KDNode {
+        double corte;         // Coordenada de la mediana en `eje`
+        uint32_t inicio, fin; // Tramo de `pts`
+        int eje;              // -1 en las hojas
+    };
+
+    // Punto junto con su posición en el vector de entrada
+    struct PuntoIndexado { Point p; uint32_t indice; };
+
+    std::vector<KDNode> nodes;
+    std::vector<PuntoIndexado> pts;
+    std::vector<double> xs, ys, zs;   // Columnas de `pts`
+    std::vector<uint32_t> ids;
+    const double eps = 1e-6;
+
+    static double coord(const Point& p, int eje) { return eje == 0 ? p.x : (eje == 1 ? p.y : p.z); }
+
+    void buildTree(size_t nodo, uint32_t inicio, uint32_t fin, int depth) {
+        KDNode& n = nodes[nodo];
+        n.inicio = inicio;
+        n.fin = fin;
+        if (fin - inicio <= TAM_HOJA) { n.eje = -1; n.corte = 0.0; return; }
+
+        int axis = depth % 3;
+        uint32_t mid = inicio + (fin - inicio) / 2;
+        std::nth_element(pts.begin() + inicio, pts.begin() + mid, pts.begin() + fin,
+            [axis](const PuntoIndexado& a, const PuntoIndexado& b) { return coord(a.p, axis) < coord(b.p, axis); });
+        n.eje = axis;
+        n.corte = coord(pts[mid].p, axis);
+
+        if (fin - inicio >= MIN_TAREA) {
+            #pragma omp task default(shared) firstprivate(nodo, inicio, mid, depth)
+            buildTree(2 * nodo + 1, inicio, mid, depth + 1);
+            #pragma omp task default(shared) firstprivate(nodo, mid, fin, depth)
+            buildTree(2 * nodo + 2, mid, fin, depth + 1);
+            #pragma omp taskwait
+        } else {
+            buildTree(2 * nodo + 1, inicio, mid, depth + 1);
+            buildTree(2 * nodo + 2, mid, fin, depth + 1);
+        }
+    }
+
+    // Distancias al cuadrado de toda la hoja a `q`
+    void distanciasHoja(const KDNode& hoja, const Point& q, double* d2) const {
+        const double* x = xs.data() + hoja.inicio;
+        const double* y = ys.data() + hoja.inicio;
+        const double* z = zs.data() + hoja.inicio;
+        uint32_t n = hoja.fin - hoja.inicio;
+        #pragma omp simd
+        for (uint32_t i = 0; i < n; ++i) {
+            double dx = x[i] - q.x, dy = y[i] - q.y, dz = z[i] - q.z;
+            d2[i] = dx * dx + dy * dy + dz * dz;
+        }
+    }
+
+    // Recorre las hojas que pueden tener algo a menos de sqrt(cota2) de `q`,
+    // la más cercana primero; `visitar` puede achicar cota2 sobre la marcha.
+    // Izquierda: coordenada <= corte; derecha: >= corte.
+    template <typename Visitar>
+    void recorrer(size_t nodo, const Point& q, const double& cota2, Visitar& visitar) const {
+        const KDNode& node = nodes[nodo];
+        if (node.eje < 0) {
+            double d2[TAM_HOJA];
+            distanciasHoja(node, q, d2);
+            visitar(node.inicio, node.fin - node.inicio, d2);
+            return;
+        }
+
+        double diff = coord(q, node.eje) - node.corte;
+        size_t near = diff <= 0 ? 2 * nodo + 1 : 2 * nodo + 2;
+        size_t far = diff <= 0 ? 2 * nodo + 2 : 2 * nodo + 1;
+
+        recorrer(near, q, cota2, visitar);
+        if (diff * diff <= cota2) {
+            recorrer(far, q, cota2, visitar);
+        }
+    }
+
+    struct Todos { bool operator()(uint32_t) const { return true; } };
+
+    // Los k más cercanos en `vecinos`, ordenados por distancia; sólo cuentan
+    // los puntos cuyo índice acepta `aceptar`
+    template <typename Aceptar = Todos>
+    void knnEn(const Point& q, size_t k, std::vector<std::pair<double, uint32_t>>& vecinos, Aceptar aceptar = {}) const {
+        vecinos.clear();
+        if (k == 0 || pts.empty()) return;
+        double cota2 = std::numeric_limits<double>::infinity();
+        auto visitar = [&](uint32_t inicio, uint32_t n, const double* d2) {
+            for (uint32_t i = 0; i < n; ++i) {
+                if (!aceptar(ids[inicio + i])) continue;
+                if (vecinos.size() < k) {
+                    vecinos.push_back({d2[i], ids[inicio + i]});
+                    std::push_heap(vecinos.begin(), vecinos.end());
+                } else if (d2[i] < vecinos.front().first) {
+                    std::pop_heap(vecinos.begin(), vecinos.end());
+                    vecinos.back() = {d2[i], ids[inicio + i]};
+                    std::push_heap(vecinos.begin(), vecinos.end());
+                }
+                if (vecinos.size() == k) cota2 = vecinos.front().first;
+            }
+        };
+        recorrer(0, q, cota2, visitar);
+        std::sort_heap(vecinos.begin(), vecinos.end());
+    }
+
+    // Posición en las columnas del más cercano aceptado, si mejora bestDist2
+    template <typename Aceptar = Todos>
+    void nearestEn(const Point& q, uint32_t& best, double& bestDist2, Aceptar aceptar = {}) const {
+        if (pts.empty()) return;
+        auto visitar = [&](uint32_t inicio, uint32_t n, const double* d2) {
+            for (uint32_t i = 0; i < n; ++i)
+                if (d2[i] < bestDist2 && aceptar(ids[inicio + i])) { bestDist2 = d2[i]; best = inicio + i; }
+        };
+        recorrer(0, q, bestDist2, visitar);
+    }
+
+    // Agrega a `dentro` sin vaciarlo
+    template <typename Aceptar = Todos>
+    void radiusEn(const Point& q, double r, std::vector<uint32_t>& dentro, Aceptar aceptar = {}) const {
+        if (pts.empty()) return;
+        const double cota2 = r * r;
+        auto visitar = [&](uint32_t inicio, uint32_t n, const double* d2) {
+            for (uint32_t i = 0; i < n; ++i)
+                if (d2[i] <= cota2 && aceptar(ids[inicio + i])) dentro.push_back(ids[inicio + i]);
+        };
+        recorrer(0, q, cota2, visitar);
+    }
+
+    friend class KDTreeDinamico;
+
+public:
+    void build(const std::vector<Point>& points) {
+        size_t n = points.size();
+        pts.resize(n);
+        #pragma omp parallel for if(n >= MIN_TAREA)
+        for (size_t i = 0; i < n; ++i) pts[i] = {points[i], (uint32_t)i};
+
+        // Profundidad máxima: mitades hasta que el tramo más largo cabe en una hoja
+        size_t niveles = 0;
+        for (size_t largo = n; largo > TAM_HOJA; largo = (largo + 1) / 2) ++niveles;
+        nodes.resize(n == 0 ? 0 : (size_t(2) << niveles) - 1);
+
+        if (n > 0) {
+            if (n >= MIN_TAREA) {
+                #pragma omp parallel
+                #pragma omp single
+                buildTree(0, 0, (uint32_t)n, 0);
+            } else {
+                buildTree(0, 0, (uint32_t)n, 0);
+            }
+        }
+
+        xs.resize(n); ys.resize(n); zs.resize(n); ids.resize(n);
+        #pragma omp parallel for if(n >= MIN_TAREA)
+        for (size_t i = 0; i < n; ++i) {
+            xs[i] = pts[i].p.x; ys[i] = pts[i].p.y; zs[i] = pts[i].p.z;
+            ids[i] = pts[i].indice;
+        }
+    }
+
+    Point findNearest(const Point& target) const {
+        if (pts.empty()) return target;
+        uint32_t best = 0;
+        double bestDist2 = std::numeric_limits<double>::infinity();
+        nearestEn(target, best, bestDist2);
+        return {xs[best], ys[best], zs[best]};
+    }
+
+    // Índice (en el vector de build) del punto más cercano; 0 si el árbol está vacío
+    uint32_t findNearestIndex(const Point& target) const {
+        if (pts.empty()) return 0;
+        uint32_t best = 0;
+        double bestDist2 = std::numeric_limits<double>::infinity();
+        nearestEn(target, best, bestDist2);
+        return ids[best];
+    }
+
+    // Índices de los k puntos más cercanos, del más cercano al más lejano
+    std::vector<uint32_t> knn(const Point& query, size_t k) const {
+        std::vector<std::pair<double, uint32_t>> vecinos;
+        knnEn(query, k, vecinos);
+        std::vector<uint32_t> r(vecinos.size());
+        for (size_t i = 0; i < vecinos.size(); ++i) r[i] = vecinos[i].second;
+        return r;
+    }
+
+    // Índices de los puntos a distancia <= r, sin orden
+    std::vector<uint32_t> radius(const Point& query, double r) const {
+        std::vector<uint32_t> dentro;
+        radiusEn(query, r, dentro);
+        return dentro;
+    }
+
+    static constexpr uint32_t SIN_VECINO = std::numeric_limits<uint32_t>::max();
+
+    // k vecinos de cada consulta, en paralelo: consulta i en [i * k, (i + 1) * k),
+    // completando con SIN_VECINO si hay menos de k puntos
+    std::vector<uint32_t> knnLote(const std::vector<Point>& queries, size_t k) const {
+        std::vector<uint32_t> r(queries.size() * k, SIN_VECINO);
+        #pragma omp parallel
+        {
+            std::vector<std::pair<double, uint32_t>> vecinos;
+            vecinos.reserve(k);
+            #pragma omp for schedule(dynamic, 256)
+            for (size_t i = 0; i < queries.size(); ++i) {
+                knnEn(queries[i], k, vecinos);
+                for (size_t j = 0; j < vecinos.size(); ++j) r[i * k + j] = vecinos[j].second;
+            }
+        }
+        return r;
+    }
+
+    std::vector<std::vector<uint32_t>> radiusLote(const std::vector<Point>& queries, double r) const {
+        std::vector<std::vector<uint32_t>> dentro(queries.size());
+        #pragma omp parallel for schedule(dynamic, 256)
+        for (size_t i = 0; i < queries.size(); ++i) radiusEn(queries[i], r, dentro[i]);
+        return dentro;
+    }
+};
+
+// ==================== KD-tree dinámico ====================
+// Bosque logarítmico de KDTree estáticos (Bentley-Saxe): el nivel i guarda
+// a lo sumo TAM_BASE * 2^i puntos. Insertar arma un árbol con los puntos
+// nuevos más los de los niveles llenos que hay que subir, así que cada
+// punto se reconstruye O(log n) veces en total y una tanda chica sólo toca
+// los niveles bajos. Borrar marca el punto; cuando un nivel tiene más de la
+// mitad borrada se rearma con los que quedan. Las consultas recorren los
+// O(log n) árboles. Los índices son los de inserción (el primer punto
+// insertado es el 0), como si todo se hubiera pasado junto a build().
+class KDTreeDinamico {
+private:
+    static const size_t TAM_BASE = 1024;
+
+    struct Nivel {
+        KDTree arbol;
+        std::vector<uint32_t> globales;   // Índice local del árbol -> índice de inserción
+        size_t borrados = 0;
+        size_t vivos() const { return globales.size() - borrados; }
+    };
+
+    std::vector<Nivel> niveles;
+    std::vector<char> borrado;        // Por índice de inserción
+    std::vector<uint8_t> nivelDe;     // Por índice de inserción
+    std::vector<Point> tanda;                  // Memoria de trabajo de insertar()
+    std::vector<uint32_t> tandaGlobales;
+
+    static size_t capacidad(size_t nivel) { return TAM_BASE << nivel; }
+
+    // Agrega a la tanda los puntos vivos del nivel y lo vacía
+    void vaciarEn(Nivel& nv) {
+        const KDTree& a = nv.arbol;
+        for (size_t i = 0; i < a.ids.size(); ++i) {
+            uint32_t g = nv.globales[a.ids[i]];
+            if (borrado[g]) continue;
+            tanda.push_back({a.xs[i], a.ys[i], a.zs[i]});
+            tandaGlobales.push_back(g);
+        }
+        nv.globales.clear();
+        nv.borrados = 0;
+    }
+
+    // El árbol del nivel se rearma con la tanda, que queda vacía
+    void armar(size_t i) {
+        Nivel& nv = niveles[i];
+        nv.arbol.build(tanda);
+        nv.globales.assign(tandaGlobales.begin(), tandaGlobales.end());
+        nv.borrados = 0;
+        for (uint32_t g : tandaGlobales) nivelDe[g] = (uint8_t)i;
+        tanda.clear();
+        tandaGlobales.clear();
+    }
+
+public:
+    size_t size() const { return borrado.size(); }
+
+    void insertar(const std::vector<Point>& nuevos) {
+        if (nuevos.empty()) return;
+        tanda.assign(nuevos.begin(), nuevos.end());
+        tandaGlobales.resize(nuevos.size());
+        std::iota(tandaGlobales.begin(), tandaGlobales.end(), (uint32_t)borrado.size());
+        borrado.resize(borrado.size() + nuevos.size(), 0);
+        nivelDe.resize(borrado.size());
+
+        // Como un contador binario: los niveles ocupados suben con la tanda
+        // hasta el primero en el que todo entra
+        for (size_t i = 0; ; ++i) {
+            if (i == niveles.size()) niveles.emplace_back();
+            if (!niveles[i].globales.empty()) vaciarEn(niveles[i]);
+            if (tanda.size() <= capacidad(i)) { armar(i); return; }
+        }
+    }
+
+    void eliminar(uint32_t indice) {
+        if (indice >= borrado.size() || borrado[indice]) return;
+        borrado[indice] = 1;
+        size_t i = nivelDe[indice];
+        Nivel& nv = niveles[i];
+        if (++nv.borrados * 2 > nv.globales.size()) {
+            vaciarEn(nv);
+            armar(i);
+        }
+    }
+
+    Point findNearest(const Point& target) const {
+        Point mejor = target;
+        double d2 = std::numeric_limits<double>::infinity();
+        for (const auto& nv : niveles) {
+            if (nv.vivos() == 0) continue;
+            uint32_t pos = UINT32_MAX;
+            nv.arbol.nearestEn(target, pos, d2, [&](uint32_t local) { return !borrado[nv.globales[local]]; });
+            if (pos != UINT32_MAX) mejor = {nv.arbol.xs[pos], nv.arbol.ys[pos], nv.arbol.zs[pos]};
+        }
+        return mejor;
+    }
+
+    std::vector<uint32_t> knn(const Point& query, size_t k) const {
+        std::vector<std::pair<double, uint32_t>> todos, vecinos;
+        for (const auto& nv : niveles) {
+            if (nv.vivos() == 0) continue;
+            nv.arbol.knnEn(query, k, vecinos, [&](uint32_t local) { return !borrado[nv.globales[local]]; });
+            for (const auto& [d2, local] : vecinos) todos.push_back({d2, nv.globales[local]});
+        }
+        size_t n = std::min(k, todos.size());
+        std::partial_sort(todos.begin(), todos.begin() + n, todos.end());
+        std::vector<uint32_t> r(n);
+        for (size_t i = 0; i < n; ++i) r[i] = todos[i].second;
+        return r;
+    }
+
+    std::vector<uint32_t> radius(const Point& query, double r) const {
+        std::vector<uint32_t> dentro;
+        for (const auto& nv : niveles) {
+            if (nv.vivos() == 0) continue;
+            size_t desde = dentro.size();
+            nv.arbol.radiusEn(query, r, dentro, [&](uint32_t local) { return !borrado[nv.globales[local]]; });
+            for (size_t i = desde; i < dentro.size(); ++i) dentro[i] = nv.globales[dentro[i]];
+        }
+        return dentro;
+    }
+};
+
+// ==================== Localización de puntos ====================
+// Responde qué tetraedro de la malla terminada contiene un punto. La malla
+// se indexa una vez (vértices únicos y, por cada cara, el tetraedro del
+// otro lado) y cada consulta salta al tetraedro de su vértice más cercano
+// (KDTree) y desde ahí camina: si una coordenada baricéntrica es negativa,
+// el punto está del otro lado de la cara opuesta a ese vértice y se cruza
+// por la más negativa. En una triangulación de Delaunay el camino es corto.
+const int MAX_PASOS_CAMINATA = 4096;
+
+struct Localizacion {
+    int64_t tetraedro;      // Índice en el vector de tetraedros; -1 si cae afuera
+    double baricentricas[4]; // Respecto de p1..p4
+};
+
+class LocalizadorTetraedros {
+public:
+    explicit LocalizadorTetraedros(const std::vector<Tetrahedron>& malla) : tets(malla) {
+        std::vector<Point> vertices;
+        std::vector<uint32_t> indices = indexarTetraedros(vertices, tets);
+        size_t nTets = tets.size();
+
+        // Caras: la cara i de un tetraedro es la opuesta a su vértice i
+        std::vector<std::pair<std::array<uint32_t, 3>, uint64_t>> caras(nTets * 4);
+        #pragma omp parallel for
+        for (size_t t = 0; t < nTets; ++t) {
+            for (int i = 0; i < 4; ++i) {
+                std::array<uint32_t, 3> c;
+                for (int j = 0, k = 0; j < 4; ++j) if (j != i) c[k++] = indices[t * 4 + j];
+                std::sort(c.begin(), c.end());
+                caras[t * 4 + i] = {c, t * 4 + i};
+            }
+        }
+        std::sort(caras.begin(), caras.end());
+
+        vecinos.assign(nTets * 4, -1);
+        for (size_t i = 0; i + 1 < caras.size(); ++i) {
+            if (caras[i].first != caras[i + 1].first) continue;
+            vecinos[caras[i].second] = (int64_t)(caras[i + 1].second / 4);
+            vecinos[caras[i + 1].second] = (int64_t)(caras[i].second / 4);
+            ++i;
+        }
+
+        tetDeVertice.assign(vertices.size(), 0);
+        for (size_t c = 0; c < indices.size(); ++c) tetDeVertice[indices[c]] = c / 4;
+        arbol.build(vertices);
+    }
+
+    Localizacion localizar(const Point& p) const {
+        Localizacion r{-1, {0, 0, 0, 0}};
+        if (!tets.empty()) caminar(p, semilla(p), MAX_PASOS_CAMINATA, r);
+        return r;
+    }
+
+    // Las consultas se recorren en orden Morton y cada una arranca desde el
+    // tetraedro de la anterior del mismo hilo; si esa caminata no llega en
+    // PASOS_DESDE_ANTERIOR pasos (o sale de la malla) se vuelve a la semilla
+    // del KDTree.
+    std::vector<Localizacion> localizarLote(const std::vector<Point>& consultas) const {
+        std::vector<Localizacion> r(consultas.size(), Localizacion{-1, {0, 0, 0, 0}});
+        if (tets.empty() || consultas.empty()) return r;
+
+        Point mn = consultas[0], mx = consultas[0];
+        for (const auto& q : consultas) {
+            mn = {std::min(mn.x, q.x), std::min(mn.y, q.y), std::min(mn.z, q.z)};
+            mx = {std::max(mx.x, q.x), std::max(mx.y, q.y), std::max(mx.z, q.z)};
+        }
+        std::vector<std::pair<uint64_t, uint32_t>> orden(consultas.size());
+        #pragma omp parallel for
+        for (size_t i = 0; i < consultas.size(); ++i) orden[i] = {codigoMorton(consultas[i], mn, mx), (uint32_t)i};
+        std::sort(orden.begin(), orden.end());
+
+        #pragma omp parallel
+        {
+            int64_t anterior = -1;
+            #pragma omp for schedule(static)
+            for (size_t k = 0; k < orden.size(); ++k) {
+                const Point& p = consultas[orden[k].second];
+                Localizacion& l = r[orden[k].second];
+                if (anterior < 0 || !caminar(p, anterior, PASOS_DESDE_ANTERIOR, l) || l.tetraedro < 0)
+                    caminar(p, semilla(p), MAX_PASOS_CAMINATA, l);
+                if (l.tetraedro >= 0) anterior = l.tetraedro;
+            }
+        }
+        return r;
+    }
+
+private:
+    std::vector<Tetrahedron> tets;        // Copia, para leer los 4 vértices de una vez
+    std::vector<int64_t> vecinos;         // 4 por tetraedro, -1 en el borde
+    std::vector<size_t> tetDeVertice;
+    KDTree arbol;
+
+    static const int PASOS_DESDE_ANTERIOR = 32;
+
+    // Seis veces el volumen con signo de abcd
+    static double orientacion(const Point& a, const Point& b, const Point& c, const Point& d) {
+        double bx = b.x - a.x, by = b.y - a.y, bz = b.z - a.z;
+        double cx = c.x - a.x, cy = c.y - a.y, cz = c.z - a.z;
+        double dx = d.x - a.x, dy = d.y - a.y, dz = d.z - a.z;
+        return bx * (cy * dz - cz * dy) - by * (cx * dz - cz * dx) + bz * (cx * dy - cy * dx);
+    }
+
+    static uint64_t expandirBits(uint64_t v) {
+        v &= 0x1fffff;
+        v = (v | v << 32) & 0x1f00000000ffffull;
+        v = (v | v << 16) & 0x1f0000ff0000ffull;
+        v = (v | v << 8)  & 0x100f00f00f00f00full;
+        v = (v | v << 4)  & 0x10c30c30c30c30c3ull;
+        v = (v | v << 2)  & 0x1249249249249249ull;
+        return v;
+    }
+
+    static uint64_t codigoMorton(const Point& p, const Point& mn, const Point& mx) {
+        auto q = [](double v, double a, double b) {
+            return b > a ? (uint64_t)((v - a) / (b - a) * 2097151.0) : 0;
+        };
+        return (expandirBits(q(p.x, mn.x, mx.x)) << 2) | (expandirBits(q(p.y, mn.y, mx.y)) << 1) |
+               expandirBits(q(p.z, mn.z, mx.z));
+    }
+
+    int64_t semilla(const Point& p) const { return tetDeVertice[arbol.findNearestIndex(p)]; }
+
+    // Camina desde `t`; devuelve false si se acabaron los pasos sin decidir.
+    // Salir por una cara de borde deja r.tetraedro en -1 (punto afuera).
+    bool caminar(const Point& p, int64_t t, int maxPasos, Localizacion& r) const {
+        r.tetraedro = -1;
+        int64_t anterior = -1;
+        for (int paso = 0; paso < maxPasos; ++paso) {
+            const Tetrahedron& tet = tets[t];
+            const Point* v[4] = {&tet.p1, &tet.p2, &tet.p3, &tet.p4};
+            double vol = orientacion(*v[0], *v[1], *v[2], *v[3]);
+            double b[4];
+            int salida = -1, salidaAtras = -1;
+            double peor = -1e-12;
+            for (int i = 0; i < 4; ++i) {
+                const Point* w[4] = {v[0], v[1], v[2], v[3]};
+                w[i] = &p;
+                b[i] = vol != 0.0 ? orientacion(*w[0], *w[1], *w[2], *w[3]) / vol : -1.0;
+                if (b[i] >= peor) continue;
+                // No se vuelve por la cara por la que se entró, salvo que no quede otra
+                if (vecinos[t * 4 + i] == anterior) salidaAtras = i;
+                else { peor = b[i]; salida = i; }
+            }
+            if (salida < 0) salida = salidaAtras;
+            if (salida < 0) {
+                r.tetraedro = t;
+                std::copy(b, b + 4, r.baricentricas);
+                return true;
+            }
+            int64_t siguiente = vecinos[t * 4 + salida];
+            if (siguiente < 0) return true;   // Se salió de la malla
+            anterior = t;
+            t = siguiente;
+        }
+        return false;
+    }
+};
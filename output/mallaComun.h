@@ -0,0 +1,209 @@
+#pragma once
+// Código común a los visores y a las herramientas de test/ que leen los .bin
+// de tetraedros: los registros y la lectura/escritura del archivo, la
+// extracción de aristas únicas y el flujo de aristas de los .qbin.
+// Los índices son uint32_t (el GLuint de los visores) para que las
+// herramientas puedan incluirlo sin glad. Todo lo definido acá es inline
+// para que lo puedan incluir varias unidades de compilación.
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <omp.h>
+
+// ==================== Estructuras ====================
+// Registros tal como están en los .bin: size_t nPuntos, Point[nPuntos],
+// size_t nTets, Tetrahedron[nTets].
+struct Point { double x, y, z; };
+struct Tetrahedron { Point p1, p2, p3, p4; };
+
+// ==================== Lectura y escritura ====================
+inline void leerBin(const std::string& ruta, std::vector<Point>& points, std::vector<Tetrahedron>& tets) {
+    std::ifstream in(ruta, std::ios::binary);
+    if (!in) throw std::runtime_error("No se pudo abrir: " + ruta);
+
+    size_t nPoints, nTets;
+    in.read(reinterpret_cast<char*>(&nPoints), sizeof(size_t));
+    points.resize(nPoints);
+    in.read(reinterpret_cast<char*>(points.data()), nPoints * sizeof(Point));
+    in.read(reinterpret_cast<char*>(&nTets), sizeof(size_t));
+    tets.resize(nTets);
+    in.read(reinterpret_cast<char*>(tets.data()), nTets * sizeof(Tetrahedron));
+    if (!in) throw std::runtime_error("Archivo truncado: " + ruta);
+}
+
+// Se escribe a un temporal y se renombra, así un corte no deja el .bin a medias
+inline void escribirBin(const std::string& ruta, const std::vector<Point>& points, const std::vector<Tetrahedron>& tets) {
+    std::string tmp = ruta + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary);
+        if (!out) throw std::runtime_error("No se pudo escribir: " + tmp);
+        size_t nPoints = points.size(), nTets = tets.size();
+        out.write(reinterpret_cast<const char*>(&nPoints), sizeof(size_t));
+        out.write(reinterpret_cast<const char*>(points.data()), nPoints * sizeof(Point));
+        out.write(reinterpret_cast<const char*>(&nTets), sizeof(size_t));
+        out.write(reinterpret_cast<const char*>(tets.data()), nTets * sizeof(Tetrahedron));
+        if (!out) throw std::runtime_error("Error escribiendo: " + tmp);
+    }
+    std::filesystem::rename(tmp, ruta);
+}
+
+// ==================== Códigos Morton ====================
+// Intercala 10 bits por eje; el código de (x, y, z) es
+// (expandirBits(x) << 2) | (expandirBits(y) << 1) | expandirBits(z).
+inline uint32_t expandirBits(uint32_t v) {
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+// ==================== Aristas únicas ====================
+// Los .bin guardan cada tetraedro con sus coordenadas, así que primero se
+// traduce cada vértice a su índice en `points` (búsqueda binaria sobre un
+// orden lexicográfico). Los vértices que no aparezcan en la lista de puntos
+// se agregan al final.
+inline std::vector<uint32_t> indexarTetraedros(std::vector<Point>& points, const std::vector<Tetrahedron>& tets) {
+    auto menor = [](const Point& a, const Point& b) {
+        return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+    };
+
+    std::vector<uint32_t> orden(points.size());
+    std::iota(orden.begin(), orden.end(), 0);
+    std::sort(orden.begin(), orden.end(), [&](uint32_t a, uint32_t b) { return menor(points[a], points[b]); });
+
+    const uint32_t SIN_INDICE = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> indices(tets.size() * 4);
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < tets.size(); ++i) {
+        const Point* v[4] = {&tets[i].p1, &tets[i].p2, &tets[i].p3, &tets[i].p4};
+        for (int k = 0; k < 4; ++k) {
+            auto it = std::lower_bound(orden.begin(), orden.end(), *v[k],
+                [&](uint32_t idx, const Point& p) { return menor(points[idx], p); });
+            indices[i * 4 + k] = (it != orden.end() && !menor(*v[k], points[*it])) ? *it : SIN_INDICE;
+        }
+    }
+
+    std::map<std::array<double, 3>, uint32_t> extra;
+    for (size_t c = 0; c < indices.size(); ++c) {
+        if (indices[c] != SIN_INDICE) continue;
+        const Tetrahedron& t = tets[c / 4];
+        const Point& p = (c % 4 == 0) ? t.p1 : (c % 4 == 1) ? t.p2 : (c % 4 == 2) ? t.p3 : t.p4;
+        auto [it, nuevo] = extra.insert({{p.x, p.y, p.z}, (uint32_t)points.size()});
+        if (nuevo) points.push_back(p);
+        indices[c] = it->second;
+    }
+    return indices;
+}
+
+// Ordena y elimina repetidos: cada hilo ordena su bloque y luego se mezclan
+// los bloques de a pares.
+inline void ordenarUnicoParalelo(std::vector<uint64_t>& claves) {
+    int nBloques = std::max(1, omp_get_max_threads());
+    std::vector<size_t> limites(nBloques + 1);
+    for (int b = 0; b <= nBloques; ++b) limites[b] = claves.size() * b / nBloques;
+
+    #pragma omp parallel for
+    for (int b = 0; b < nBloques; ++b)
+        std::sort(claves.begin() + limites[b], claves.begin() + limites[b + 1]);
+
+    for (int paso = 1; paso < nBloques; paso *= 2) {
+        #pragma omp parallel for
+        for (int b = 0; b < nBloques - paso; b += 2 * paso) {
+            size_t fin = limites[std::min(b + 2 * paso, nBloques)];
+            std::inplace_merge(claves.begin() + limites[b], claves.begin() + limites[b + paso], claves.begin() + fin);
+        }
+    }
+    claves.erase(std::unique(claves.begin(), claves.end()), claves.end());
+}
+
+// Cada arista se codifica como (menor índice << 32 | mayor índice), de modo
+// que las aristas compartidas entre tetraedros vecinos colapsan en una sola.
+// Devuelve pares de índices listos para GL_ELEMENT_ARRAY_BUFFER.
+inline std::vector<uint32_t> extraerAristasUnicas(const std::vector<uint32_t>& tetIndices) {
+    static const int aristas[6][2] = {{0,1},{1,2},{2,0},{0,3},{1,3},{2,3}};
+    size_t nTets = tetIndices.size() / 4;
+    std::vector<uint64_t> claves(nTets * 6);
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < nTets; ++i) {
+        const uint32_t* v = &tetIndices[i * 4];
+        for (int e = 0; e < 6; ++e) {
+            uint64_t a = v[aristas[e][0]], b = v[aristas[e][1]];
+            claves[i * 6 + e] = (std::min(a, b) << 32) | std::max(a, b);
+        }
+    }
+
+    ordenarUnicoParalelo(claves);
+
+    std::vector<uint32_t> lineIndices(claves.size() * 2);
+    #pragma omp parallel for
+    for (size_t i = 0; i < claves.size(); ++i) {
+        lineIndices[i * 2] = (uint32_t)(claves[i] >> 32);
+        lineIndices[i * 2 + 1] = (uint32_t)(claves[i] & 0xffffffffu);
+    }
+    return lineIndices;
+}
+
+// ==================== Flujo de aristas de los .qbin ====================
+// El formato completo está en test/compactarMalla.cpp; superficieMascaras
+// escribe el mismo encabezado con un bloque de triángulos en vez del de
+// borde. Las aristas (a < b, ordenadas) van como dos varint LEB128 cada
+// una: a - aAnterior y b - a.
+const char MAGIA_COMPACTO[4] = {'Q', 'B', 'N', '1'};
+const char MAGIA_BORDE[4] = {'B', 'R', 'D', '1'};
+const char MAGIA_TRIANGULOS[4] = {'T', 'R', 'I', '1'};
+
+inline void escribirVarint(std::vector<uint8_t>& out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+inline std::vector<uint8_t> codificarAristas(const std::vector<std::pair<uint32_t, uint32_t>>& aristas) {
+    std::vector<uint8_t> flujo;
+    flujo.reserve(aristas.size() * 2);
+    uint32_t anterior = 0;
+    for (const auto& [a, b] : aristas) {
+        escribirVarint(flujo, a - anterior);
+        escribirVarint(flujo, b - a);
+        anterior = a;
+    }
+    return flujo;
+}
+
+// Deja en `destino` los 2 * nAristas índices; `ruta` sólo va en los errores
+inline void decodificarAristas(const std::vector<uint8_t>& flujo, uint32_t nAristas, uint32_t nPuntos,
+                               std::vector<uint32_t>& destino, const std::string& ruta) {
+    size_t pos = 0;
+    auto varint = [&]() {
+        uint32_t v = 0;
+        for (int desp = 0; ; desp += 7) {
+            if (pos == flujo.size() || desp > 28) throw std::runtime_error("Flujo de aristas corrupto: " + ruta);
+            uint8_t b = flujo[pos++];
+            v |= uint32_t(b & 0x7f) << desp;
+            if (!(b & 0x80)) return v;
+        }
+    };
+    destino.resize((size_t)nAristas * 2);
+    uint32_t a = 0;
+    for (uint32_t e = 0; e < nAristas; ++e) {
+        a += varint();
+        uint32_t b = a + varint();
+        if (b >= nPuntos) throw std::runtime_error("Arista fuera de rango: " + ruta);
+        destino[e * 2] = a;
+        destino[e * 2 + 1] = b;
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+// Formato .octree que escribe test/construirOctree.cpp y lee organo:
+//   MAGIA_OCTREE, nNodos (uint32), NodoOctree[nNodos] y después los puntos
+//   de cada nodo como float x, y, z a partir de su `offset`.
+#include <cstddef>
+#include <cstdint>
+
+// Nodo tal como se guarda en el .octree. Jerarquía aditiva: los puntos de
+// un nodo no se repiten en sus hijos, así que dibujar un subárbol cerrado
+// hacia arriba (si un hijo está, su padre también) da la unión sin duplicar.
+struct NodoOctree {
+    float centro[3];
+    float mitad;          // Semilado del cubo
+    int32_t hijos[8];     // -1 si no existe
+    uint32_t nivel;
+    uint32_t nPuntos;
+    uint64_t offset;      // Bytes desde el inicio del archivo
+};
+static_assert(sizeof(NodoOctree) == 64, "NodoOctree se lee y escribe tal cual en el .octree");
+
+// RESOLUCION_NODO^3 <= MAX_PUNTOS_NODO, así cada nodo cabe en un slot fijo
+// del pool de GPU del visor.
+const int RESOLUCION_NODO = 16;
+const size_t MAX_PUNTOS_NODO = 4096;
+const char MAGIA_OCTREE[4] = {'O', 'C', 'T', '1'};
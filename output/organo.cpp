@@ -4,6 +4,18 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <deque>
+#include <queue>
+#include <tuple>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <condition_variable>
 #include <fstream>
 #include <vector>
 #include <string>
@@ -11,20 +23,33 @@
 #include <sstream>
 #include <map>
 #include <random>
+#include <omp.h>
+
+#include "mallaComun.h"
+#include "escenaComun.h"
+#include "octreeComun.h"
 
 // ==================== Estructuras ====================
-struct Point { double x, y, z; };
-struct Tetrahedron { Point p1, p2, p3, p4; };
+// Nodo del BVH de selección: un rango contiguo de `points`, en coordenadas del .bin
+struct NodoBVH {
+    AABB caja;
+    uint32_t inicio, fin;
+    int32_t hijo;                    // El derecho es hijo + 1; -1 en las hojas
+};
 
 struct ModelPart {
-    GLuint VAO_points, VBO_points;
-    size_t pointCount;
+    std::string nombre;
+    size_t firstPoint, pointCount;   // Rango en VBO_scene
     glm::vec3 color;
-    std::vector<Point> points; // Para normalización global
-};
-
-struct Range {
-    double minX, maxX, minY, maxY, minZ, maxZ;
+    bool visible = true;
+    Range rango;                     // Rango original del órgano
+    glm::vec3 escala, desplazamiento; // Afín [-1, 1] del órgano -> caja global
+    std::vector<Point> points;       // Tal como vienen en el .bin
+    AABB caja;                       // En coordenadas del .bin
+    std::vector<Bloque> bloques;
+    std::vector<NodoBVH> bvh;        // Para elegir puntos con el mouse
+    bool cargada = false;            // Ya está en VBO_scene (o es una parte con octree)
+    int octree = -1;                 // Índice en `octrees`, -1 si se dibuja completa
 };
 
 // ==================== Variables globales ====================
@@ -35,12 +60,20 @@ float yaw = -90.0f, pitch = 0.0f;
 float sensitivity = 0.2f;
 float radius = 10.0f;
 bool firstMouse = true;
+bool modoSeleccion = false;      // Cursor libre: el mouse elige en vez de orbitar
 double lastX = 400, lastY = 300;
 float fov = 45.0f;
 
 glm::vec3 cameraPos;
 glm::vec3 cameraUp(0.0f, 1.0f, 0.0f);
 
+// ==================== Buffers de escena ====================
+// Ver escenaComun.h; acá las partes sólo tienen puntos, así que no hay EBO.
+GLuint VAO_scene, UBO_partes;
+BuffersEscena escena;
+RangosDibujo dibujo;
+int parteSeleccionada = -1;       // -1: ninguna
+
 // ==================== Mapa de colores base ====================
 std::map<std::string, glm::vec3> coloresBase = {
     {"bloodMasks", glm::vec3(0.8f, 0.0f, 0.0f)},      // Rojo oscuro
@@ -64,30 +97,61 @@ std::map<std::string, glm::vec3> coloresBase = {
 
 
 // ==================== Shaders ====================
+// Todas las partes comparten un VBO; aPart indexa el bloque de partes, que
+// guarda el color y la afín (escala, desplazamiento) que lleva las
+// coordenadas crudas del .bin a la caja global. El tamaño de los arreglos
+// debe coincidir con MAX_PARTES.
 const char* vertexShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in uint aPart;
+layout (std140) uniform Partes {
+    vec4 colores[256];
+    vec4 escalas[256];
+    vec4 desplazamientos[256];
+};
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+flat out vec3 vColor;
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vColor = colores[aPart].rgb;
+    vec3 pos = aPos * escalas[aPart].xyz + desplazamientos[aPart].xyz;
+    gl_Position = projection * view * model * vec4(pos, 1.0);
 }
 )";
 
 const char* fragmentShaderSource = R"(
 #version 330 core
+flat in vec3 vColor;
 out vec4 FragColor;
-uniform vec3 uColor;
 void main() {
-    FragColor = vec4(uColor, 1.0);
+    FragColor = vec4(vColor, 1.0);
 }
 )";
 
 GLuint shaderProgram;
 
+// ==================== Redibujado a demanda ====================
+// Sólo se dibuja cuando algo cambió (cámara, teclado, ventana expuesta o
+// nodos de octree recién subidos). Con el modo progresivo (P) los cuadros
+// durante el movimiento usan un umbral de LOD FACTOR_MOVIMIENTO veces más
+// grueso y, tras QUIETUD_S sin movimiento, se refina.
+const double QUIETUD_S = 0.15;
+const float FACTOR_MOVIMIENTO = 4.0f;
+bool redibujar = true;
+bool modoProgresivo = false;
+bool cuadroReducido = false;   // El último cuadro dibujado usó el LOD grueso
+double ultimoMovimiento = -1.0;
+
+void marcarMovimiento() {
+    redibujar = true;
+    ultimoMovimiento = glfwGetTime();
+}
+
 // ==================== Callbacks ====================
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+    if (modoSeleccion) return;
     if (firstMouse) { lastX = xpos; lastY = ypos; firstMouse = false; }
     float xoffset = xpos - lastX;
     float yoffset = lastY - ypos;
@@ -96,12 +160,18 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     yaw += xoffset; pitch += yoffset;
     if (pitch > 89.0f) pitch = 89.0f;
     if (pitch < -89.0f) pitch = -89.0f;
+    marcarMovimiento();
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     radius -= yoffset;
     if (radius < 1.0f) radius = 1.0f;
     if (radius > 100.0f) radius = 100.0f;
+    marcarMovimiento();
+}
+
+void refresh_callback(GLFWwindow* window) {
+    redibujar = true;
 }
 
 // ==================== Utilidades ====================
@@ -161,8 +231,8 @@ void cargarRangosOriginales(const std::vector<std::string>& archivosTxt, const s
 }
 
 // ==================== Color por órgano ====================
-glm::vec3 obtenerColorPorArchivo(const std::string& nombreArchivo) {
-    // Extraer órgano base
+// Órgano base: lo que sigue a "tiff_" hasta "_parte" o "_grupo"
+std::string nombreOrgano(const std::string& nombreArchivo) {
     std::string organo;
     size_t pos1 = nombreArchivo.find("tiff_");
     size_t pos2 = nombreArchivo.find("_parte");
@@ -173,6 +243,13 @@ glm::vec3 obtenerColorPorArchivo(const std::string& nombreArchivo) {
         else
             organo = nombreArchivo.substr(pos1 + 5);
     }
+    return organo;
+}
+
+glm::vec3 obtenerColorPorArchivo(const std::string& nombreArchivo) {
+    std::string organo = nombreOrgano(nombreArchivo);
+    size_t pos2 = nombreArchivo.find("_parte");
+    if (pos2 == std::string::npos) pos2 = nombreArchivo.find("_grupo");
 
     // Color base
     glm::vec3 baseColor(0.5f, 0.5f, 0.5f);
@@ -199,96 +276,561 @@ glm::vec3 obtenerColorPorArchivo(const std::string& nombreArchivo) {
 }
 
 // ==================== Cargar modelo ====================
-void loadModel(const std::string& fileName, ModelPart& part, const Range& r) {
+// Se llama desde los hilos del cargador: sólo toca los campos de `part`
+// que el hilo de GL no lee hasta que la parte está cargada. Este visor no
+// dibuja aristas, así que los tetraedros no se leen.
+void loadModel(const std::string& fileName, ModelPart& part) {
     std::ifstream in(fileName, std::ios::binary);
     if (!in) throw std::runtime_error("No se pudo abrir: " + fileName);
 
-    size_t nPoints, nTets;
+    size_t nPoints;
     in.read(reinterpret_cast<char*>(&nPoints), sizeof(size_t));
     part.points.resize(nPoints);
     in.read(reinterpret_cast<char*>(part.points.data()), nPoints * sizeof(Point));
+    if (!in) throw std::runtime_error("Archivo incompleto: " + fileName);
 
-    in.read(reinterpret_cast<char*>(&nTets), sizeof(size_t));
-    std::vector<Tetrahedron> tets(nTets);
-    in.read(reinterpret_cast<char*>(tets.data()), nTets * sizeof(Tetrahedron));
+    // Sin desnormalizar: la afín de la parte se aplica en el shader
+    part.pointCount = nPoints;
+}
 
-    // Desnormalizar
-    auto desnormalizar = [&](Point& p) {
-        p.x = ((p.x + 1) / 2.0) * (r.maxX - r.minX) + r.minX;
-        p.y = ((p.y + 1) / 2.0) * (r.maxY - r.minY) + r.minY;
-        p.z = ((p.z + 1) / 2.0) * (r.maxZ - r.minZ) + r.minZ;
-    };
+// ==================== Frustum culling ====================
+// Ver escenaComun.h. El orden Morton también lo aprovecha el BVH de
+// selección en las partes de un solo bloque.
+ConteoDibujo estadisticas;
+
+// ==================== Selección por rayo ====================
+// Con Tab el cursor queda libre y un clic izquierdo lanza un rayo desde la
+// cámara. Cada parte tiene un BVH sobre sus puntos ya ordenados por Morton:
+// partir cada rango por la mitad da nodos compactos sin reordenar nada, y
+// se arma en el hilo del cargador junto con los bloques. El rayo es un cono
+// de TOLERANCIA_SELECCION_PX de radio en pantalla y gana el punto más
+// cercano a la cámara dentro de él; todo en CPU, sin leer de la GPU. Las
+// partes con octree no se eligen: sus puntos están en el disco.
+const uint32_t TAM_HOJA_BVH = 64;
+const float TOLERANCIA_SELECCION_PX = 4.0f;
+
+struct Seleccion {
+    int parte;              // -1 si el rayo no tocó nada
+    Point punto;            // En coordenadas del .bin
+    glm::vec3 posicion;     // En la caja global
+    float distancia;        // Desde la cámara, a lo largo del rayo
+};
+
+// Llena el nodo idx (con inicio y fin ya puestos) y su subárbol
+void armarNodoBVH(std::vector<NodoBVH>& bvh, const std::vector<Point>& points, size_t idx) {
+    uint32_t inicio = bvh[idx].inicio, fin = bvh[idx].fin;
+    AABB c = cajaVacia();
+    if (fin - inicio <= TAM_HOJA_BVH) {
+        for (uint32_t i = inicio; i < fin; ++i) expandir(c, points[i]);
+    } else {
+        uint32_t medio = inicio + (fin - inicio) / 2;
+        int32_t hijo = bvh.size();
+        bvh.push_back({cajaVacia(), inicio, medio, -1});
+        bvh.push_back({cajaVacia(), medio, fin, -1});
+        bvh[idx].hijo = hijo;
+        for (int h = 0; h < 2; ++h) {
+            armarNodoBVH(bvh, points, hijo + h);
+            c.min = glm::min(c.min, bvh[hijo + h].caja.min);
+            c.max = glm::max(c.max, bvh[hijo + h].caja.max);
+        }
+    }
+    bvh[idx].caja = c;
+}
 
-    for (auto& p : part.points) desnormalizar(p);
+void construirBVH(ModelPart& part) {
+    part.bvh.clear();
+    if (part.points.empty()) return;
+    if (part.points.size() > UINT32_MAX) throw std::runtime_error("Demasiados puntos para el BVH: " + part.nombre);
+    part.bvh.reserve(2 * (part.points.size() / TAM_HOJA_BVH + 1));
+    part.bvh.push_back({cajaVacia(), 0, (uint32_t)part.points.size(), -1});
+    armarNodoBVH(part.bvh, part.points, 0);
+}
 
-    part.pointCount = nPoints;
-    part.color = obtenerColorPorArchivo(fileName);
+// `dir` normalizado; tanCono es la tangente del semiángulo del cono
+void seleccionarEnParte(int indice, const glm::vec3& origen, const glm::vec3& dir, float tanCono, Seleccion& mejor) {
+    const ModelPart& part = modelParts[indice];
+    std::vector<uint32_t> pila{0};
+    while (!pila.empty()) {
+        const NodoBVH& nodo = part.bvh[pila.back()];
+        pila.pop_back();
+
+        // Esfera que envuelve la caja, contra el cono
+        glm::vec3 mn = nodo.caja.min * part.escala + part.desplazamiento;
+        glm::vec3 mx = nodo.caja.max * part.escala + part.desplazamiento;
+        glm::vec3 v = (mn + mx) * 0.5f - origen;
+        float radio = glm::length(mx - mn) * 0.5f;
+        float t = glm::dot(v, dir);
+        if (t + radio < 0.0f || t - radio >= mejor.distancia) continue;
+        float perp = std::sqrt(std::max(glm::dot(v, v) - t * t, 0.0f));
+        if (perp > radio + tanCono * (t + radio)) continue;
+
+        if (nodo.hijo >= 0) {
+            // Primero el hijo más cercano a la cámara: sale primero de la pila
+            glm::vec3 c0 = (part.bvh[nodo.hijo].caja.min + part.bvh[nodo.hijo].caja.max) * 0.5f;
+            glm::vec3 c1 = (part.bvh[nodo.hijo + 1].caja.min + part.bvh[nodo.hijo + 1].caja.max) * 0.5f;
+            bool izquierdoCerca = glm::dot(c0 * part.escala + part.desplazamiento - origen, dir) <
+                                  glm::dot(c1 * part.escala + part.desplazamiento - origen, dir);
+            pila.push_back(nodo.hijo + (izquierdoCerca ? 1 : 0));
+            pila.push_back(nodo.hijo + (izquierdoCerca ? 0 : 1));
+            continue;
+        }
+        for (uint32_t i = nodo.inicio; i < nodo.fin; ++i) {
+            const Point& p = part.points[i];
+            glm::vec3 g = glm::vec3((float)p.x, (float)p.y, (float)p.z) * part.escala + part.desplazamiento;
+            glm::vec3 w = g - origen;
+            float tp = glm::dot(w, dir);
+            if (tp <= 0.0f || tp >= mejor.distancia) continue;
+            float r = tanCono * tp;
+            if (glm::dot(w, w) - tp * tp <= r * r) mejor = {indice, p, g, tp};
+        }
+    }
 }
 
-// ==================== Normalización global ====================
-void normalizarGlobal() {
-    double gMinX = 1e9, gMaxX = -1e9;
-    double gMinY = 1e9, gMaxY = -1e9;
-    double gMinZ = 1e9, gMaxZ = -1e9;
+Seleccion seleccionar(const glm::vec3& origen, const glm::vec3& dir, float tanCono) {
+    Seleccion mejor{-1, {0, 0, 0}, glm::vec3(0.0f), 1e30f};
+    for (size_t i = 0; i < modelParts.size(); ++i) {
+        const ModelPart& part = modelParts[i];
+        if (!part.visible || !part.cargada || part.octree >= 0 || part.bvh.empty()) continue;
+        seleccionarEnParte(i, origen, dir, tanCono, mejor);
+    }
+    return mejor;
+}
+
+// Rayo por el cursor con la misma cámara que dibujarCuadro
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (!modoSeleccion || button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) return;
+    double x, y;
+    int ancho, alto;
+    glfwGetCursorPos(window, &x, &y);
+    glfwGetWindowSize(window, &ancho, &alto);
+    if (ancho <= 0 || alto <= 0) return;
+
+    float tanY = std::tan(glm::radians(fov) / 2.0f);
+    float ndcX = (float)(2.0 * x / ancho - 1.0), ndcY = (float)(1.0 - 2.0 * y / alto);
+    glm::vec3 frente = glm::normalize(-cameraPos);
+    glm::vec3 derecha = glm::normalize(glm::cross(frente, cameraUp));
+    glm::vec3 arriba = glm::cross(derecha, frente);
+    glm::vec3 dir = glm::normalize(frente + derecha * (ndcX * tanY * 800.0f / 600.0f) + arriba * (ndcY * tanY));
+    float tanCono = TOLERANCIA_SELECCION_PX * 2.0f * tanY / alto;
+
+    auto t0 = std::chrono::steady_clock::now();
+    Seleccion s = seleccionar(cameraPos, dir, tanCono);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    if (s.parte < 0) {
+        std::cout << "Selección: nada (" << us << " us)\n";
+        return;
+    }
+
+    // Del .bin ([-1, 1] por órgano) a las coordenadas originales
+    parteSeleccionada = s.parte;
+    const ModelPart& part = modelParts[s.parte];
+    const Range& r = part.rango;
+    std::cout << "Selección: " << nombreOrgano(part.nombre) << " (" << part.nombre << ") en ("
+              << r.minX + (s.punto.x + 1.0) / 2.0 * (r.maxX - r.minX) << ", "
+              << r.minY + (s.punto.y + 1.0) / 2.0 * (r.maxY - r.minY) << ", "
+              << r.minZ + (s.punto.z + 1.0) / 2.0 * (r.maxZ - r.minZ) << "), "
+              << us << " us\n";
+}
 
-    for (auto& part : modelParts) {
-        for (auto& p : part.points) {
-            gMinX = std::min(gMinX, p.x); gMaxX = std::max(gMaxX, p.x);
-            gMinY = std::min(gMinY, p.y); gMaxY = std::max(gMaxY, p.y);
-            gMinZ = std::min(gMinZ, p.z); gMaxZ = std::max(gMaxZ, p.z);
+// ==================== Buffers de escena ====================
+// Arma los rangos de dibujo con las partes visibles y los bloques que tocan
+// el frustum (los rangos contiguos se fusionan); no sube nada a la GPU.
+void actualizarRangosDibujo() {
+    dibujo.limpiar();
+    estadisticas = {};
+
+    for (const auto& part : modelParts) {
+        if (!part.visible || !part.cargada || part.octree >= 0) continue;
+        agregarBloquesVisibles(part.bloques, part.firstPoint, 0, cajaVisible(part.caja, part.escala, part.desplazamiento),
+                               [&](const AABB& c) { return cajaVisible(c, part.escala, part.desplazamiento); }, dibujo, estadisticas);
+    }
+}
+
+// Sube colores y afines por parte. Reencuadrar o agregar un órgano sólo
+// requiere normalizarGlobal + esta función, sin tocar los vértices.
+void actualizarBloquePartes() {
+    std::vector<glm::vec4> bloque(3 * MAX_PARTES, glm::vec4(0.0f));
+    for (size_t i = 0; i < modelParts.size(); ++i) {
+        bloque[i] = glm::vec4(modelParts[i].color, 1.0f);
+        bloque[MAX_PARTES + i] = glm::vec4(modelParts[i].escala, 0.0f);
+        bloque[2 * MAX_PARTES + i] = glm::vec4(modelParts[i].desplazamiento, 0.0f);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO_partes);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, bloque.size() * sizeof(glm::vec4), bloque.data());
+}
+
+// VBO_scene arranca vacío y crece a medida que llegan las partes (ver
+// "Carga en paralelo"); el bloque de partes ya queda completo, porque la
+// afín de cada parte sólo depende de los rangos.
+void crearBuffersEscena() {
+    crearEscena(modelParts.size(), shaderProgram, "Partes", 3 * MAX_PARTES * sizeof(glm::vec4), VAO_scene, UBO_partes);
+    actualizarBloquePartes();
+}
+
+// ==================== Carga en paralelo ====================
+// Ver escenaComun.h; cada parte se lee, reordena (construirBloques), arma su
+// BVH y empaqueta en los hilos del cargador.
+
+// Corre en los hilos del cargador
+void decodificarParte(size_t i, const std::string& ruta, ParteLista& lista) {
+    ModelPart& part = modelParts[i];
+    loadModel(ruta, part);
+    std::vector<GLuint> sinAristas;
+    construirBloques(part.points, sinAristas, {}, part.caja, part.bloques);
+    construirBVH(part);
+    lista.vertices = empaquetarPuntos(part.points, i);
+}
+
+void descartarParte(size_t i) {
+    ModelPart& part = modelParts[i];
+    part.points.clear(); part.bloques.clear(); part.bvh.clear();
+    part.pointCount = 0;
+}
+
+CargadorPartes cargadorPartes;
+
+void enlazarBuffersEscena() {
+    glBindVertexArray(VAO_scene);
+    glBindBuffer(GL_ARRAY_BUFFER, escena.vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertice), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertice), (void*)offsetof(Vertice, parte));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+}
+
+// Devuelve cuántas partes subió
+size_t subirPartes(size_t maxBytes) {
+    return subirPartesListas(cargadorPartes, escena, sizeof(Vertice), maxBytes,
+        [](size_t i, size_t firstPoint, size_t) {
+            ModelPart& part = modelParts[i];
+            part.firstPoint = firstPoint;
+            part.cargada = true;
+        }, enlazarBuffersEscena);
+}
+
+// Flechas: elegir parte, espacio: mostrar/ocultar, 0: mostrar todas,
+// P: modo progresivo, Tab: orbitar o elegir con el mouse (la parte
+// elegida pasa a ser la seleccionada).
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action != GLFW_PRESS || modelParts.empty()) return;
+    redibujar = true;
+    if (key == GLFW_KEY_P) {
+        modoProgresivo = !modoProgresivo;
+        std::cout << "Modo progresivo: " << (modoProgresivo ? "si" : "no") << "\n";
+        return;
+    }
+    if (key == GLFW_KEY_TAB) {
+        modoSeleccion = !modoSeleccion;
+        glfwSetInputMode(window, GLFW_CURSOR, modoSeleccion ? GLFW_CURSOR_NORMAL : GLFW_CURSOR_DISABLED);
+        firstMouse = true;
+        std::cout << "Modo selección: " << (modoSeleccion ? "si" : "no") << "\n";
+        return;
+    }
+    teclaPartes(key, modelParts, parteSeleccionada);
+}
+
+// ==================== LOD por octree ====================
+// Las partes con un .octree (ver test/construirOctree.cpp) no se suben
+// completas: en cada cuadro se eligen nodos por error en pantalla hasta
+// PRESUPUESTO_PUNTOS y los que faltan se leen del disco en un hilo aparte.
+// Cada nodo ocupa un slot fijo de MAX_PUNTOS_NODO vértices en VBO_lod
+// (NodoOctree y los parámetros del formato vienen de octreeComun.h).
+
+struct OctreeParte {
+    std::string ruta;
+    int parte;                  // Índice en modelParts
+    std::vector<NodoOctree> nodos;
+    std::vector<int> slot;      // Slot en VBO_lod, -1 si no está residente
+};
+
+const size_t PRESUPUESTO_PUNTOS = 2000000;
+const size_t SLOTS_LOD = PRESUPUESTO_PUNTOS * 3 / 2 / MAX_PUNTOS_NODO;
+const float UMBRAL_ERROR_PX = 1.0f;  // Separación entre puntos tolerada en pantalla
+const size_t MAX_SUBIDAS_POR_CUADRO = 8;
+const float ALTO_VENTANA = 600.0f;
+
+std::vector<OctreeParte> octrees;
+GLuint VAO_lod, VBO_lod;
+std::vector<std::pair<int, int>> duenoSlot; // (octree, nodo) de cada slot
+std::vector<uint64_t> usoSlot;              // Último cuadro en que se dibujó
+std::vector<GLint> lodFirsts;
+std::vector<GLsizei> lodCounts;
+uint64_t cuadroActual = 0;
+
+struct PedidoNodo { int octree, nodo; };
+struct NodoCargado { int octree, nodo; std::vector<float> puntos; };
+
+// Hilo lector. Sólo lee `octrees[].nodos`, que no cambia después de cargar.
+class CargadorNodos {
+public:
+    ~CargadorNodos() { detener(); }
+
+    void iniciar() { hilo = std::thread([this] { trabajar(); }); }
+
+    void detener() {
+        { std::lock_guard<std::mutex> lock(m); terminar = true; }
+        cv.notify_one();
+        if (hilo.joinable()) hilo.join();
+    }
+
+    // Reemplaza los pendientes: los pedidos de cuadros anteriores ya no importan
+    void pedir(const std::vector<PedidoNodo>& nuevos) {
+        { std::lock_guard<std::mutex> lock(m); pendientes.assign(nuevos.begin(), nuevos.end()); }
+        cv.notify_one();
+    }
+
+    std::vector<NodoCargado> tomarListos(size_t max) {
+        std::lock_guard<std::mutex> lock(m);
+        std::vector<NodoCargado> r;
+        while (!listos.empty() && r.size() < max) {
+            r.push_back(std::move(listos.front()));
+            listos.pop_front();
         }
+        return r;
     }
 
-    for (auto& part : modelParts) {
-        for (auto& p : part.points) {
-            p.x = ((p.x - gMinX) / (gMaxX - gMinX)) * 2 - 1;
-            p.y = ((p.y - gMinY) / (gMaxY - gMinY)) * 2 - 1;
-            p.z = ((p.z - gMinZ) / (gMaxZ - gMinZ)) * 2 - 1;
+private:
+    void trabajar() {
+        std::vector<std::ifstream> archivos(octrees.size());
+        while (true) {
+            PedidoNodo p;
+            {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [this] { return terminar || !pendientes.empty(); });
+                if (terminar) return;
+                p = pendientes.front();
+                pendientes.pop_front();
+            }
+
+            const OctreeParte& oct = octrees[p.octree];
+            const NodoOctree& nodo = oct.nodos[p.nodo];
+            std::ifstream& in = archivos[p.octree];
+            if (!in.is_open()) in.open(oct.ruta, std::ios::binary);
+
+            NodoCargado c{p.octree, p.nodo, std::vector<float>(nodo.nPuntos * 3)};
+            in.seekg(nodo.offset);
+            in.read(reinterpret_cast<char*>(c.puntos.data()), c.puntos.size() * sizeof(float));
+            if (!in) { in.clear(); continue; }
+
+            {
+                std::lock_guard<std::mutex> lock(m);
+                listos.push_back(std::move(c));
+            }
+            glfwPostEmptyEvent(); // Despierta al render loop si está esperando eventos
         }
+    }
 
-        std::vector<float> pointData;
-        for (auto& p : part.points) {
-            pointData.insert(pointData.end(), {(float)p.x, (float)p.y, (float)p.z});
+    std::thread hilo;
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<PedidoNodo> pendientes;
+    std::deque<NodoCargado> listos;
+    bool terminar = false;
+};
+
+CargadorNodos cargador;
+
+// Sólo se lee la tabla de nodos; los puntos llegan bajo demanda.
+void cargarOctree(const std::string& ruta, ModelPart& part, const Range& r, int indiceParte) {
+    std::ifstream in(ruta, std::ios::binary);
+    if (!in) throw std::runtime_error("No se pudo abrir: " + ruta);
+
+    char magia[4];
+    uint32_t nNodos;
+    in.read(magia, sizeof(magia));
+    if (!in || !std::equal(magia, magia + 4, MAGIA_OCTREE)) throw std::runtime_error("Octree no reconocido: " + ruta);
+    in.read(reinterpret_cast<char*>(&nNodos), sizeof(uint32_t));
+
+    OctreeParte oct;
+    oct.ruta = ruta;
+    oct.parte = indiceParte;
+    oct.nodos.resize(nNodos);
+    in.read(reinterpret_cast<char*>(oct.nodos.data()), nNodos * sizeof(NodoOctree));
+    if (!in) throw std::runtime_error("Archivo truncado: " + ruta);
+    oct.slot.assign(nNodos, -1);
+
+    part.rango = r;
+    part.pointCount = 0;
+    part.color = obtenerColorPorArchivo(ruta);
+    part.cargada = true;
+    part.octree = octrees.size();
+    octrees.push_back(std::move(oct));
+}
+
+void crearPoolLOD() {
+    duenoSlot.assign(SLOTS_LOD, {-1, -1});
+    usoSlot.assign(SLOTS_LOD, 0);
+
+    glGenVertexArrays(1, &VAO_lod);
+    glGenBuffers(1, &VBO_lod);
+    glBindVertexArray(VAO_lod);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_lod);
+    glBufferData(GL_ARRAY_BUFFER, SLOTS_LOD * MAX_PUNTOS_NODO * sizeof(Vertice), nullptr, GL_DYNAMIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertice), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertice), (void*)offsetof(Vertice, parte));
+    glEnableVertexAttribArray(1);
+    glBindVertexArray(0);
+
+    cargador.iniciar();
+}
+
+// Separación aproximada entre los puntos del nodo, en píxeles.
+float errorEnPantalla(const OctreeParte& oct, const NodoOctree& nodo) {
+    const ModelPart& part = modelParts[oct.parte];
+    glm::vec3 centro = glm::vec3(nodo.centro[0], nodo.centro[1], nodo.centro[2]) * part.escala + part.desplazamiento;
+    float radio = glm::length(part.escala * nodo.mitad);
+    float dist = std::max(glm::length(centro - cameraPos) - radio, 0.1f);
+    float tamPx = radio / (dist * std::tan(glm::radians(fov) / 2.0f)) * ALTO_VENTANA;
+    return tamPx / RESOLUCION_NODO;
+}
+
+// Recorre los octrees de mayor a menor error. Un nodo sólo se refina si ya
+// está residente, así que lo dibujado siempre es un subárbol completo. Los
+// nodos fuera del frustum se descartan junto con su subárbol.
+void seleccionarNodosLOD(float umbral) {
+    ++cuadroActual;
+    lodFirsts.clear(); lodCounts.clear();
+
+    std::vector<PedidoNodo> faltantes;
+    std::priority_queue<std::tuple<float, int, int>> cola;
+    for (size_t o = 0; o < octrees.size(); ++o) {
+        if (!modelParts[octrees[o].parte].visible || octrees[o].nodos.empty()) continue;
+        cola.emplace(errorEnPantalla(octrees[o], octrees[o].nodos[0]), o, 0);
+    }
+
+    size_t puntos = 0;
+    while (!cola.empty()) {
+        auto [error, o, n] = cola.top();
+        cola.pop();
+        OctreeParte& oct = octrees[o];
+        const NodoOctree& nodo = oct.nodos[n];
+        const ModelPart& part = modelParts[oct.parte];
+        glm::vec3 centro(nodo.centro[0], nodo.centro[1], nodo.centro[2]), mitad(nodo.mitad);
+        if (!cajaVisible({centro - mitad, centro + mitad}, part.escala, part.desplazamiento)) {
+            estadisticas.puntosDescartados += nodo.nPuntos;
+            continue;
         }
+        if (puntos + nodo.nPuntos > PRESUPUESTO_PUNTOS) break;
+        if (oct.slot[n] < 0) { faltantes.push_back({o, n}); continue; }
+
+        int s = oct.slot[n];
+        usoSlot[s] = cuadroActual;
+        lodFirsts.push_back((GLint)(s * MAX_PUNTOS_NODO));
+        lodCounts.push_back((GLsizei)nodo.nPuntos);
+        puntos += nodo.nPuntos;
+        estadisticas.puntosDibujados += nodo.nPuntos;
+
+        // Los trozos extra de una hoja llena (mismo nivel) van siempre con ella
+        for (int h : nodo.hijos)
+            if (h >= 0 && (error > umbral || oct.nodos[h].nivel == nodo.nivel))
+                cola.emplace(errorEnPantalla(oct, oct.nodos[h]), o, h);
+    }
+    cargador.pedir(faltantes);
+}
 
-        glGenVertexArrays(1, &part.VAO_points);
-        glGenBuffers(1, &part.VBO_points);
-        glBindVertexArray(part.VAO_points);
-        glBindBuffer(GL_ARRAY_BUFFER, part.VBO_points);
-        glBufferData(GL_ARRAY_BUFFER, pointData.size() * sizeof(float), pointData.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+// Desaloja el slot menos usado que no se haya dibujado en este cuadro.
+int reservarSlot() {
+    int elegido = -1;
+    uint64_t masViejo = cuadroActual;
+    for (size_t s = 0; s < duenoSlot.size(); ++s) {
+        if (duenoSlot[s].first < 0) return s;
+        if (usoSlot[s] < masViejo) { masViejo = usoSlot[s]; elegido = s; }
     }
+    if (elegido >= 0) octrees[duenoSlot[elegido].first].slot[duenoSlot[elegido].second] = -1;
+    return elegido;
+}
+
+// Como mucho MAX_SUBIDAS_POR_CUADRO nodos por cuadro, para acotar el tiempo
+// de subida. Devuelve cuántos nodos subió.
+size_t subirNodosListos() {
+    size_t subidos = 0;
+    std::vector<Vertice> vertices;
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_lod);
+    for (auto& c : cargador.tomarListos(MAX_SUBIDAS_POR_CUADRO)) {
+        OctreeParte& oct = octrees[c.octree];
+        if (oct.slot[c.nodo] >= 0) continue;
+        int s = reservarSlot();
+        if (s < 0) break;
+
+        size_t n = c.puntos.size() / 3;
+        vertices.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            vertices[i] = {c.puntos[i * 3], c.puntos[i * 3 + 1], c.puntos[i * 3 + 2], (GLuint)oct.parte};
+        glBufferSubData(GL_ARRAY_BUFFER, s * MAX_PUNTOS_NODO * sizeof(Vertice), n * sizeof(Vertice), vertices.data());
+
+        oct.slot[c.nodo] = s;
+        duenoSlot[s] = {c.octree, c.nodo};
+        usoSlot[s] = cuadroActual;
+        ++subidos;
+    }
+    return subidos;
 }
 
 // ==================== Render loop ====================
+void dibujarCuadro(bool reducido) {
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    cameraPos.x = radius * cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    cameraPos.y = radius * sin(glm::radians(pitch));
+    cameraPos.z = radius * sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), cameraUp);
+    glm::mat4 proj = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 200.0f);
+
+    extraerPlanosFrustum(proj * view * model);
+    actualizarRangosDibujo();
+
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
+
+    // Una sola llamada para todas las partes visibles
+    glBindVertexArray(VAO_scene);
+    glMultiDrawArrays(GL_POINTS, dibujo.pointFirsts.data(), dibujo.pointCounts.data(), dibujo.pointFirsts.size());
+
+    if (!octrees.empty()) {
+        seleccionarNodosLOD(reducido ? UMBRAL_ERROR_PX * FACTOR_MOVIMIENTO : UMBRAL_ERROR_PX);
+        glBindVertexArray(VAO_lod);
+        glMultiDrawArrays(GL_POINTS, lodFirsts.data(), lodCounts.data(), lodFirsts.size());
+    }
+}
+
 void renderLoop(GLFWwindow* window) {
+    double ultimoTitulo = 0.0;
     while (!glfwWindowShouldClose(window)) {
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        cameraPos.x = radius * cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-        cameraPos.y = radius * sin(glm::radians(pitch));
-        cameraPos.z = radius * sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), cameraUp);
-        glm::mat4 proj = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 200.0f);
-
-        glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
-
-        for (auto& part : modelParts) {
-            glUniform3fv(glGetUniformLocation(shaderProgram, "uColor"), 1, glm::value_ptr(part.color));
-            glBindVertexArray(part.VAO_points);
-            glPointSize(3.0f);
-            glDrawArrays(GL_POINTS, 0, part.pointCount);
+        // Lo que llegó del disco se sube aunque no haya que dibujar todavía
+        size_t subidos = octrees.empty() ? 0 : subirNodosListos();
+        if (subidos > 0) redibujar = true;
+        if (subirPartes(MAX_BYTES_SUBIDA) > 0) {
+            redibujar = true;
+            if (!cargadorPartes.pendientes()) std::cout << "Carga completa: " << cargadorPartes.msCarga() << " ms\n";
         }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        bool moviendo = glfwGetTime() - ultimoMovimiento < QUIETUD_S;
+        if (redibujar || (cuadroReducido && !moviendo)) {
+            bool reducido = modoProgresivo && moviendo;
+            dibujarCuadro(reducido);
+            glfwSwapBuffers(window);
+            redibujar = false;
+            cuadroReducido = reducido;
+
+            if (glfwGetTime() - ultimoTitulo > 0.5) {
+                ultimoTitulo = glfwGetTime();
+                std::ostringstream titulo;
+                titulo << "Puntos " << estadisticas.puntosDibujados << " (descartados " << estadisticas.puntosDescartados << ")";
+                glfwSetWindowTitle(window, titulo.str().c_str());
+            }
+        }
+
+        // Si quedaron nodos o partes por subir no se espera; si falta el
+        // cuadro completo, se despierta a tiempo
+        if (subidos == MAX_SUBIDAS_POR_CUADRO || cargadorPartes.hayListas()) glfwPollEvents();
+        else glfwWaitEventsTimeout(cuadroReducido ? QUIETUD_S : 0.5);
     }
 }
 
@@ -305,10 +847,14 @@ int main() {
 
         glfwSetCursorPosCallback(window, mouse_callback);
         glfwSetScrollCallback(window, scroll_callback);
+        glfwSetMouseButtonCallback(window, mouse_button_callback);
+        glfwSetKeyCallback(window, key_callback);
+        glfwSetWindowRefreshCallback(window, refresh_callback);
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
         gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
         glEnable(GL_DEPTH_TEST);
+        glPointSize(3.0f);
 
         shaderProgram = compileShader(vertexShaderSource, fragmentShaderSource);
 
@@ -371,22 +917,39 @@ int main() {
             "puntos_tiff_stomachMasks.txt"};
         cargarRangosOriginales(archivosTxt, "puntos_separados");
 
+        // Los octrees sólo leen su tabla de nodos; los .bin se registran con
+        // su rango y color y la geometría llega después desde el cargador.
+        std::vector<std::pair<size_t, std::string>> rutasBin;
         for (const auto& nombre : archivosTxt) {
             std::string baseName = nombre.substr(0, nombre.find_last_of("."));
             std::string rutaBin = "output/" + baseName + ".txt.bin";
+            std::string rutaOctree = "output/" + baseName + ".txt.octree";
 
-            if (std::filesystem::exists(rutaBin)) {
+            if (std::filesystem::exists(rutaOctree)) {
+                ModelPart part;
+                part.nombre = baseName;
+                cargarOctree(rutaOctree, part, rangos[nombre], modelParts.size());
+                modelParts.push_back(part);
+                std::cout << "Cargado (LOD): " << rutaOctree << "\n";
+            } else if (std::filesystem::exists(rutaBin)) {
                 ModelPart part;
-                loadModel(rutaBin, part, rangos[nombre]);
+                part.nombre = baseName;
+                part.rango = rangos[nombre];
+                part.color = obtenerColorPorArchivo(rutaBin);
+                rutasBin.emplace_back(modelParts.size(), rutaBin);
                 modelParts.push_back(part);
-                std::cout << "Cargado: " << rutaBin << "\n";
             } else {
                 std::cerr << "No encontrado: " << rutaBin << "\n";
             }
         }
 
-        normalizarGlobal();
+        normalizarGlobal(modelParts);
+        crearBuffersEscena();
+        if (!octrees.empty()) crearPoolLOD();
+        cargadorPartes.iniciar(rutasBin, decodificarParte, descartarParte);
         renderLoop(window);
+        cargadorPartes.detener();
+        cargador.detener();
         glfwTerminate();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
@@ -4,6 +4,13 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <tuple>
 #include <fstream>
 #include <vector>
 #include <string>
@@ -11,22 +18,56 @@
 #include <sstream>
 #include <map>
 #include <random>
+#include <chrono>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <omp.h>
+
+#include "mallaComun.h"
+#include "escenaComun.h"
 
 // ==================== Estructuras ====================
-struct Point { double x, y, z; };
-struct Tetrahedron { Point p1, p2, p3, p4; };
+// Índice de intervalos para los cortes: por eje, cada tetraedro con su
+// [mínimo, máximo] sobre ese eje. Los tetraedros se agrupan por extensión
+// (clases en potencias de 2) y cada clase se ordena por el mínimo, así que
+// los que cruzan un plano son un tramo contiguo por clase.
+struct EntradaIntervalo { float minimo, maximo; GLuint tet; };
 
-struct ModelPart {
-    GLuint VAO_points, VBO_points;
-    GLuint VAO_lines, VBO_lines;
-    size_t pointCount, lineCount;
-    glm::vec3 color;
-    std::vector<Point> points;
-    std::vector<Tetrahedron> tets;
+struct ClaseIntervalos {
+    float extensionMax = 0.0f;
+    std::vector<EntradaIntervalo> entradas;
 };
 
-struct Range {
-    double minX, maxX, minY, maxY, minZ, maxZ;
+// Representaciones de una parte, de la más barata a la completa (ver "Nivel de detalle")
+enum Representacion { REP_MUESTRA, REP_BORDE, REP_REDUCIDA, REP_COMPLETA, NUM_REPRESENTACIONES };
+
+struct ModelPart {
+    std::string nombre;
+    size_t firstPoint, pointCount;   // Rango en VBO_scene
+    size_t firstLine, lineCount;     // Rango en EBO_scene
+    glm::vec3 color;
+    bool visible = true;
+    Range rango;                     // Rango original del órgano
+    glm::vec3 escala, desplazamiento; // Afín [-1, 1] del órgano -> caja global
+    std::vector<Point> points;       // Tal como vienen en el .bin
+    std::vector<GLuint> lineIndices; // Índices locales a `points`
+    std::vector<GLuint> tetIndices;  // 4 por tetraedro; vacío con .qbin
+    std::vector<ClaseIntervalos> intervalos[3];
+    AABB caja;                       // En coordenadas del .bin
+    std::vector<Bloque> bloques;
+    bool cargada = false;            // Ya está en los buffers de escena
+    // Representaciones reducidas. Sus índices van en EBO_scene después de
+    // lineIndices y los puntos del nivel reducido en VBO_scene después de
+    // `points`, así que todas usan firstPoint como base.
+    std::vector<GLuint> muestraIndices;   // Subconjunto de `points`
+    std::vector<GLuint> bordeIndices;     // Aristas de las caras de borde
+    std::vector<Point> puntosReducidos;   // Del .lodN.bin de simplificarMalla
+    std::vector<GLuint> aristasReducidas; // Ya desplazadas por points.size()
+    size_t firstMuestra = 0, firstBorde = 0, firstReducida = 0; // Relativos a firstLine
+    Representacion representacion = REP_COMPLETA;
 };
 
 // ==================== Variables globales ====================
@@ -37,34 +78,126 @@ float yaw = -90.0f, pitch = 0.0f;
 float sensitivity = 0.2f;
 float radius = 10.0f;
 bool firstMouse = true;
+bool arrastrandoCorte = false;   // Botón derecho apretado con un corte activo
 double lastX = 400, lastY = 300;
 float fov = 45.0f;
 
 glm::vec3 cameraPos;
 glm::vec3 cameraUp(0.0f, 1.0f, 0.0f);
 
+// ==================== Buffers de escena ====================
+// Ver escenaComun.h.
+// Por defecto las posiciones viajan cuantizadas a 16 bits por eje relativos
+// a la caja de la parte (8 bytes por vértice en vez de 16); el shader las
+// recibe normalizadas a [0, 1] y la afín de la parte incluye la caja.
+// --flotante vuelve a los floats.
+struct VerticeCuantizado { GLushort x, y, z, parte; };
+bool verticesCuantizados = true;
+
+size_t tamVertice() { return verticesCuantizados ? sizeof(VerticeCuantizado) : sizeof(Vertice); }
+
+GLuint VAO_scene, UBO_partes;
+BuffersEscena escena;
+RangosDibujo dibujo;
+std::vector<GLsizei> muestraCounts;       // Muestras de puntos, dibujadas por índice
+std::vector<const void*> muestraOffsets;
+std::vector<GLint> muestraBaseVertex;
+int parteSeleccionada = -1;       // -1: ninguna
+
+// Qué entradas de `dibujo` y de muestraOffsets son de cada parte, para medirlas por separado
+struct TramoParte { size_t parte, primerPunto, nPuntos, primeraArista, nAristas, primeraMuestra, nMuestras; };
+std::vector<TramoParte> tramosParte;
+
 // ==================== Shaders ====================
+// Todas las partes comparten un VBO; aPart indexa el bloque de partes, que
+// guarda el color y la afín (escala, desplazamiento) que lleva las
+// coordenadas crudas del .bin a la caja global. El tamaño de los arreglos
+// debe coincidir con MAX_PARTES.
 const char* vertexShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in uint aPart;
+layout (std140) uniform Partes {
+    vec4 colores[256];
+    vec4 escalas[256];
+    vec4 desplazamientos[256];
+};
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec4 planoCorte;   // Sólo cuenta con GL_CLIP_DISTANCE0 habilitado
+flat out vec3 vColor;
 void main() {
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    vColor = colores[aPart].rgb;
+    vec3 pos = aPos * escalas[aPart].xyz + desplazamientos[aPart].xyz;
+    gl_ClipDistance[0] = dot(planoCorte, vec4(pos, 1.0));
+    gl_Position = projection * view * model * vec4(pos, 1.0);
 }
 )";
 
 const char* fragmentShaderSource = R"(
 #version 330 core
+flat in vec3 vColor;
 out vec4 FragColor;
-uniform vec3 uColor;
 void main() {
-    FragColor = vec4(uColor, 1.0);
+    FragColor = vec4(vColor, 1.0);
 }
 )";
 
-GLuint shaderProgram;
+// Gráfico de tiempos de cuadro, en coordenadas de pantalla
+const char* overlayVertexShaderSource = R"(
+#version 330 core
+layout (location = 0) in vec2 aPos;
+void main() {
+    gl_Position = vec4(aPos, 0.0, 1.0);
+}
+)";
+
+const char* overlayFragmentShaderSource = R"(
+#version 330 core
+uniform vec3 color;
+out vec4 FragColor;
+void main() {
+    FragColor = vec4(color, 1.0);
+}
+)";
+
+GLuint shaderProgram, shaderOverlay;
+
+// ==================== Redibujado a demanda ====================
+// Sólo se dibuja cuando algo cambió (cámara, teclado, ventana expuesta).
+// Con el modo progresivo (P) los cuadros durante el movimiento se dibujan
+// sin aristas y, tras QUIETUD_S sin movimiento, se dibuja uno completo.
+const double QUIETUD_S = 0.15;
+bool redibujar = true;
+bool modoProgresivo = false;
+bool cuadroReducido = false;   // El último cuadro dibujado no tenía aristas
+double ultimoMovimiento = -1.0;
+
+void marcarMovimiento() {
+    redibujar = true;
+    ultimoMovimiento = glfwGetTime();
+}
+
+// ==================== Corte por plano ====================
+// C recorre sin corte -> X -> Y -> Z, V invierte el lado que se conserva y
+// arrastrar con el botón derecho mueve el plano. El plano es perpendicular a
+// un eje de la caja global; como la afín de cada parte es por eje, en
+// coordenadas del .bin también lo es y alcanza con un índice por eje.
+// Los puntos y aristas del lado cortado se recortan en el shader
+// (gl_ClipDistance) y la sección se rellena con el color del órgano.
+const float SENSIBILIDAD_CORTE = 0.005f;   // Caja global por píxel
+
+int ejeCorte = -1;          // -1 sin corte
+float posCorte = 0.0f;      // En la caja global, [-1, 1]
+float ladoCorte = 1.0f;     // Se conserva lo que cumple lado * (coord - pos) >= 0
+bool corteSucio = true;     // La sección no corresponde al plano o a las partes visibles
+
+void moverCorte(float pixeles) {
+    posCorte = std::min(std::max(posCorte + pixeles * SENSIBILIDAD_CORTE, -1.0f), 1.0f);
+    corteSucio = true;
+    marcarMovimiento();
+}
 
 // ==================== Callbacks ====================
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -72,16 +205,28 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     float xoffset = xpos - lastX;
     float yoffset = lastY - ypos;
     lastX = xpos; lastY = ypos;
+    if (arrastrandoCorte) { moverCorte(yoffset); return; }
     xoffset *= sensitivity; yoffset *= sensitivity;
     yaw += xoffset; pitch += yoffset;
     if (pitch > 89.0f) pitch = 89.0f;
     if (pitch < -89.0f) pitch = -89.0f;
+    marcarMovimiento();
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods) {
+    if (button != GLFW_MOUSE_BUTTON_RIGHT) return;
+    arrastrandoCorte = action == GLFW_PRESS && ejeCorte >= 0;
 }
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     radius -= yoffset;
     if (radius < 1.0f) radius = 1.0f;
     if (radius > 100.0f) radius = 100.0f;
+    marcarMovimiento();
+}
+
+void refresh_callback(GLFWwindow* window) {
+    redibujar = true;
 }
 
 // ==================== Utilidades ====================
@@ -142,150 +287,1025 @@ void cargarRangosOriginales(const std::vector<std::string>& archivosTxt, const s
     }
 }
 
-void loadModel(const std::string& fileName, ModelPart& part, const Range& r) {
+// .qbin de compactarMalla: posiciones cuantizadas y aristas ya únicas,
+// codificadas como varint (ver el formato en test/compactarMalla.cpp), y
+// después las aristas de borde, que sin tetraedros no se pueden calcular.
+// Los de superficieMascaras traen en su lugar un bloque de triángulos que
+// acá no se lee. Las magias y el flujo de aristas vienen de mallaComun.h.
+
+void loadCompacto(const std::string& fileName, ModelPart& part) {
     std::ifstream in(fileName, std::ios::binary);
     if (!in) throw std::runtime_error("No se pudo abrir: " + fileName);
 
-    size_t nPoints, nTets;
-    in.read(reinterpret_cast<char*>(&nPoints), sizeof(size_t));
-    part.points.resize(nPoints);
-    in.read(reinterpret_cast<char*>(part.points.data()), nPoints * sizeof(Point));
+    char magia[4];
+    uint32_t nPuntos, nAristas;
+    float mn[3], mx[3];
+    in.read(magia, sizeof(magia));
+    if (!in || !std::equal(magia, magia + 4, MAGIA_COMPACTO)) throw std::runtime_error("No es un .qbin: " + fileName);
+    in.read(reinterpret_cast<char*>(&nPuntos), sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(&nAristas), sizeof(uint32_t));
+    in.read(reinterpret_cast<char*>(mn), sizeof(mn));
+    in.read(reinterpret_cast<char*>(mx), sizeof(mx));
 
-    in.read(reinterpret_cast<char*>(&nTets), sizeof(size_t));
-    part.tets.resize(nTets);
-    in.read(reinterpret_cast<char*>(part.tets.data()), nTets * sizeof(Tetrahedron));
+    std::vector<uint16_t> q(nPuntos * 3);
+    in.read(reinterpret_cast<char*>(q.data()), q.size() * sizeof(uint16_t));
+    part.points.resize(nPuntos);
+    for (uint32_t i = 0; i < nPuntos; ++i) {
+        Point& p = part.points[i];
+        p.x = mn[0] + (mx[0] - mn[0]) * (q[i * 3] / 65535.0);
+        p.y = mn[1] + (mx[1] - mn[1]) * (q[i * 3 + 1] / 65535.0);
+        p.z = mn[2] + (mx[2] - mn[2]) * (q[i * 3 + 2] / 65535.0);
+    }
 
-    auto desnormalizar = [&](Point& p) {
-        p.x = ((p.x + 1) / 2.0) * (r.maxX - r.minX) + r.minX;
-        p.y = ((p.y + 1) / 2.0) * (r.maxY - r.minY) + r.minY;
-        p.z = ((p.z + 1) / 2.0) * (r.maxZ - r.minZ) + r.minZ;
-    };
+    uint64_t bytesAristas;
+    in.read(reinterpret_cast<char*>(&bytesAristas), sizeof(uint64_t));
+    std::vector<uint8_t> flujo(bytesAristas);
+    in.read(reinterpret_cast<char*>(flujo.data()), flujo.size());
+    if (!in) throw std::runtime_error("Archivo truncado: " + fileName);
+    decodificarAristas(flujo, nAristas, nPuntos, part.lineIndices, fileName);
 
-    for (auto& p : part.points) desnormalizar(p);
-    for (auto& t : part.tets) { desnormalizar(t.p1); desnormalizar(t.p2); desnormalizar(t.p3); desnormalizar(t.p4); }
+    part.bordeIndices.clear();
+    in.read(magia, sizeof(magia));
+    if (in && std::equal(magia, magia + 4, MAGIA_BORDE)) {
+        uint32_t nBorde;
+        in.read(reinterpret_cast<char*>(&nBorde), sizeof(uint32_t));
+        in.read(reinterpret_cast<char*>(&bytesAristas), sizeof(uint64_t));
+        flujo.resize(bytesAristas);
+        in.read(reinterpret_cast<char*>(flujo.data()), flujo.size());
+        if (!in) throw std::runtime_error("Archivo truncado: " + fileName);
+        decodificarAristas(flujo, nBorde, nPuntos, part.bordeIndices, fileName);
+    }
+    part.pointCount = part.points.size();
+    part.lineCount = part.lineIndices.size();
+}
+
+// Se llama desde los hilos del cargador: sólo toca los campos de `part`
+// que el hilo de GL no lee hasta que la parte está cargada.
+void loadModel(const std::string& fileName, ModelPart& part) {
+    if (std::filesystem::path(fileName).extension() == ".qbin") { loadCompacto(fileName, part); return; }
 
-    part.pointCount = nPoints;
-    part.lineCount = nTets * 12;
+    std::vector<Tetrahedron> tets;
+    leerBin(fileName, part.points, tets);
 
-    static std::mt19937 gen{ std::random_device{}() };
-    std::uniform_real_distribution<float> dist(0.2f, 1.0f);
-    part.color = glm::vec3(dist(gen), dist(gen), dist(gen));
+    // Sin desnormalizar: la afín de la parte se aplica en el shader
+    part.tetIndices = indexarTetraedros(part.points, tets);
+    part.lineIndices = extraerAristasUnicas(part.tetIndices);
+    part.pointCount = part.points.size();
+    part.lineCount = part.lineIndices.size();
 }
 
-void normalizarGlobal() {
-    double gMinX = 1e9, gMaxX = -1e9;
-    double gMinY = 1e9, gMaxY = -1e9;
-    double gMinZ = 1e9, gMaxZ = -1e9;
+// ==================== Frustum culling ====================
+// Ver escenaComun.h. De las partes en orden Morton también sale la muestra
+// de "Nivel de detalle".
+struct Estadisticas : ConteoDibujo {
+    size_t partesPorRepresentacion[NUM_REPRESENTACIONES];
+};
+Estadisticas estadisticas;
+
+// ==================== Sección del corte ====================
+// Ver "Corte por plano". Cada plano nuevo sólo recorre, por clase de
+// extensión, el tramo de tetraedros con mínimo en [d - extensiónMáx, d];
+// los que además tienen máximo >= d se cortan en un triángulo o un
+// cuadrilátero. La sección se arma en CPU (en paralelo por parte) y se
+// sube entera a VBO_corte, con las posiciones en el mismo espacio que
+// VBO_scene para que la afín del bloque de partes sirva tal cual.
+const int MAX_CLASES_INTERVALOS = 24;
+
+GLuint VAO_corte = 0, VBO_corte = 0;
+size_t verticesCorte = 0, tetsCandidatos = 0;
+double msCorte = 0.0;
+
+double coordenada(const Point& p, int eje) { return eje == 0 ? p.x : eje == 1 ? p.y : p.z; }
 
-    for (auto& part : modelParts) {
-        for (auto& p : part.points) {
-            gMinX = std::min(gMinX, p.x); gMaxX = std::max(gMaxX, p.x);
-            gMinY = std::min(gMinY, p.y); gMaxY = std::max(gMaxY, p.y);
-            gMinZ = std::min(gMinZ, p.z); gMaxZ = std::max(gMaxZ, p.z);
+// Se llama desde el cargador, después de construirBloques (usa los índices ya reordenados)
+void construirIntervalos(ModelPart& part) {
+    size_t nTets = part.tetIndices.size() / 4;
+    for (int eje = 0; eje < 3; ++eje) {
+        auto& clases = part.intervalos[eje];
+        clases.clear();
+        if (nTets == 0) continue;
+
+        std::vector<EntradaIntervalo> entradas(nTets);
+        #pragma omp parallel for
+        for (size_t t = 0; t < nTets; ++t) {
+            double mn = 1e300, mx = -1e300;
+            for (int k = 0; k < 4; ++k) {
+                double c = coordenada(part.points[part.tetIndices[t * 4 + k]], eje);
+                mn = std::min(mn, c);
+                mx = std::max(mx, c);
+            }
+            // Redondeo hacia afuera: el filtro en float nunca pierde un tetraedro
+            entradas[t] = {std::nextafter((float)mn, -1e30f), std::nextafter((float)mx, 1e30f), (GLuint)t};
         }
+
+        // La clase 0 llega hasta la mediana de las extensiones; cada clase siguiente duplica
+        std::vector<float> ext(nTets);
+        for (size_t t = 0; t < nTets; ++t) ext[t] = entradas[t].maximo - entradas[t].minimo;
+        std::nth_element(ext.begin(), ext.begin() + nTets / 2, ext.end());
+        float referencia = std::max(ext[nTets / 2], 1e-12f);
+
+        clases.resize(MAX_CLASES_INTERVALOS);
+        for (const auto& e : entradas) {
+            float r = (e.maximo - e.minimo) / referencia;
+            int k = r <= 1.0f ? 0 : std::min(MAX_CLASES_INTERVALOS - 1, (int)std::ceil(std::log2(r)));
+            clases[k].entradas.push_back(e);
+            clases[k].extensionMax = std::max(clases[k].extensionMax, e.maximo - e.minimo);
+        }
+        clases.erase(std::remove_if(clases.begin(), clases.end(),
+                                    [](const ClaseIntervalos& c) { return c.entradas.empty(); }), clases.end());
+        for (auto& c : clases)
+            std::sort(c.entradas.begin(), c.entradas.end(),
+                      [](const EntradaIntervalo& a, const EntradaIntervalo& b) { return a.minimo < b.minimo; });
     }
+}
 
-    for (auto& part : modelParts) {
-        auto norm = [&](Point& p) {
-            p.x = ((p.x - gMinX) / (gMaxX - gMinX)) * 2 - 1;
-            p.y = ((p.y - gMinY) / (gMaxY - gMinY)) * 2 - 1;
-            p.z = ((p.z - gMinZ) / (gMaxZ - gMinZ)) * 2 - 1;
-        };
+// Posición en el espacio de VBO_scene: con vértices cuantizados, [0, 1] de la caja de la parte
+glm::vec3 aEspacioEscena(const ModelPart& part, double x, double y, double z) {
+    glm::vec3 p((float)x, (float)y, (float)z);
+    if (!verticesCuantizados) return p;
+    return (p - part.caja.min) / glm::max(part.caja.max - part.caja.min, glm::vec3(1e-30f));
+}
 
-        for (auto& p : part.points) norm(p);
-        for (auto& t : part.tets) { norm(t.p1); norm(t.p2); norm(t.p3); norm(t.p4); }
+// Agrega el polígono donde el plano coord[eje] = d corta al tetraedro t
+void cortarTetraedro(const ModelPart& part, size_t t, int eje, double d, GLuint parte, std::vector<Vertice>& out) {
+    const Point* v[4];
+    double s[4];
+    int arriba[4], abajo[4], nArriba = 0, nAbajo = 0;
+    for (int k = 0; k < 4; ++k) {
+        v[k] = &part.points[part.tetIndices[t * 4 + k]];
+        s[k] = coordenada(*v[k], eje) - d;
+        if (s[k] >= 0.0) arriba[nArriba++] = k;
+        else abajo[nAbajo++] = k;
+    }
+    if (nArriba == 0 || nAbajo == 0) return;
 
-        // Buffers para puntos
-        std::vector<float> pointData;
-        for (auto& p : part.points) pointData.insert(pointData.end(), {(float)p.x, (float)p.y, (float)p.z});
+    auto cruce = [&](int i, int j) {
+        double a = s[i] / (s[i] - s[j]);
+        glm::vec3 p = aEspacioEscena(part, v[i]->x + (v[j]->x - v[i]->x) * a, v[i]->y + (v[j]->y - v[i]->y) * a,
+                                     v[i]->z + (v[j]->z - v[i]->z) * a);
+        return Vertice{p.x, p.y, p.z, parte};
+    };
+    if (nArriba == 2) {
+        // Cuadrilátero: las cuatro aristas que cruzan, en orden alrededor del polígono
+        Vertice q[4] = {cruce(arriba[0], abajo[0]), cruce(arriba[0], abajo[1]),
+                        cruce(arriba[1], abajo[1]), cruce(arriba[1], abajo[0])};
+        out.insert(out.end(), {q[0], q[1], q[2], q[0], q[2], q[3]});
+        return;
+    }
+    const int* solo = nArriba == 1 ? arriba : abajo;
+    const int* otros = nArriba == 1 ? abajo : arriba;
+    out.insert(out.end(), {cruce(solo[0], otros[0]), cruce(solo[0], otros[1]), cruce(solo[0], otros[2])});
+}
 
-        glGenVertexArrays(1, &part.VAO_points);
-        glGenBuffers(1, &part.VBO_points);
-        glBindVertexArray(part.VAO_points);
-        glBindBuffer(GL_ARRAY_BUFFER, part.VBO_points);
-        glBufferData(GL_ARRAY_BUFFER, pointData.size() * sizeof(float), pointData.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
+void actualizarCorte() {
+    auto t0 = std::chrono::steady_clock::now();
+    static std::vector<std::vector<Vertice>> porParte;
+    porParte.resize(modelParts.size());
+    size_t candidatos = 0;
 
-        // Buffers para aristas
-        std::vector<float> lineData;
-        for (auto& t : part.tets) {
-            auto addEdge = [&](Point a, Point b) {
-                lineData.insert(lineData.end(), {(float)a.x, (float)a.y, (float)a.z,
-                                                 (float)b.x, (float)b.y, (float)b.z});
-            };
-            addEdge(t.p1, t.p2); addEdge(t.p2, t.p3); addEdge(t.p3, t.p1);
-            addEdge(t.p1, t.p4); addEdge(t.p2, t.p4); addEdge(t.p3, t.p4);
+    #pragma omp parallel for schedule(dynamic) reduction(+:candidatos)
+    for (size_t i = 0; i < modelParts.size(); ++i) {
+        const ModelPart& part = modelParts[i];
+        std::vector<Vertice>& out = porParte[i];
+        out.clear();
+        if (!part.visible || !part.cargada || part.intervalos[ejeCorte].empty()) continue;
+
+        // Plano global -> coordenadas del .bin de la parte
+        float escala = part.escala[ejeCorte];
+        if (escala == 0.0f) continue;
+        double d = (posCorte - part.desplazamiento[ejeCorte]) / escala;
+        float df = (float)d;
+
+        for (const auto& c : part.intervalos[ejeCorte]) {
+            auto ini = std::lower_bound(c.entradas.begin(), c.entradas.end(), df - c.extensionMax,
+                                        [](const EntradaIntervalo& e, float v) { return e.minimo < v; });
+            for (auto it = ini; it != c.entradas.end() && it->minimo <= df; ++it) {
+                if (it->maximo < df) continue;
+                ++candidatos;
+                cortarTetraedro(part, it->tet, ejeCorte, d, (GLuint)i, out);
+            }
         }
+    }
+
+    static std::vector<Vertice> todos;
+    todos.clear();
+    for (const auto& v : porParte) todos.insert(todos.end(), v.begin(), v.end());
 
-        glGenVertexArrays(1, &part.VAO_lines);
-        glGenBuffers(1, &part.VBO_lines);
-        glBindVertexArray(part.VAO_lines);
-        glBindBuffer(GL_ARRAY_BUFFER, part.VBO_lines);
-        glBufferData(GL_ARRAY_BUFFER, lineData.size() * sizeof(float), lineData.data(), GL_STATIC_DRAW);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    if (!VAO_corte) {
+        glGenVertexArrays(1, &VAO_corte);
+        glGenBuffers(1, &VBO_corte);
+        glBindVertexArray(VAO_corte);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO_corte);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertice), (void*)0);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertice), (void*)offsetof(Vertice, parte));
         glEnableVertexAttribArray(0);
+        glEnableVertexAttribArray(1);
+        glBindVertexArray(0);
+    }
+    // Huérfano en cada cambio: el driver no espera al cuadro anterior
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_corte);
+    glBufferData(GL_ARRAY_BUFFER, todos.size() * sizeof(Vertice), todos.data(), GL_STREAM_DRAW);
+
+    verticesCorte = todos.size();
+    tetsCandidatos = candidatos;
+    msCorte = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    corteSucio = false;
+}
+
+// ==================== Nivel de detalle ====================
+// Cada parte puede dibujarse como una muestra de sus puntos, las aristas de
+// sus caras de borde, el nivel reducido de simplificarMalla (puntos y
+// aristas del .lodN.bin) o completa. Cada cuadro se elige una por parte:
+// la que pide su tamaño proyectado en pantalla, siempre que el total de
+// primitivas (puntos + aristas) no pase del presupuesto. Las partes suben
+// de la más grande a la más chica en pantalla, empezando por la
+// seleccionada, que siempre pide la completa. L activa y desactiva.
+const size_t MAX_MUESTRA = 4096;
+const float PX_BORDE = 48.0f;       // Diámetro en pantalla desde el que se pide cada representación
+const float PX_REDUCIDA = 160.0f;
+const float PX_COMPLETA = 480.0f;
+const float ALTO_VENTANA_PX = 600.0f;
+const size_t PRESUPUESTO_POR_DEFECTO = 4000000;
+const int NIVELES_REDUCIDOS[] = {2, 1};   // .lod2.bin si existe, si no .lod1.bin
+
+bool lodActivo = true;
+size_t presupuestoPrimitivas = PRESUPUESTO_POR_DEFECTO;
+
+// Muestra: uno de cada tantos puntos en orden Morton (construirBloques ya
+// los reordenó), que queda repartida en el espacio. Borde: aristas de las
+// caras que aparecen en un solo tetraedro; sin tetraedros (.qbin) quedan
+// las que trae el archivo, si las trae.
+void construirRepresentaciones(ModelPart& part) {
+    size_t n = part.points.size();
+    part.muestraIndices.clear();
+    size_t paso = std::max<size_t>(1, (n + MAX_MUESTRA - 1) / MAX_MUESTRA);
+    for (size_t i = 0; i < n; i += paso) part.muestraIndices.push_back((GLuint)i);
+
+    size_t nTets = part.tetIndices.size() / 4;
+    if (nTets == 0) return;
+    std::vector<std::array<GLuint, 3>> caras(nTets * 4);
+    #pragma omp parallel for
+    for (size_t t = 0; t < nTets; ++t) {
+        const GLuint* v = &part.tetIndices[t * 4];
+        for (int k = 0; k < 4; ++k) {
+            std::array<GLuint, 3> c;
+            for (int j = 0, m = 0; j < 4; ++j) if (j != k) c[m++] = v[j];
+            std::sort(c.begin(), c.end());
+            caras[t * 4 + k] = c;
+        }
+    }
+    std::sort(caras.begin(), caras.end());
+
+    std::vector<uint64_t> claves;
+    for (size_t i = 0; i < caras.size(); ) {
+        size_t j = i + 1;
+        while (j < caras.size() && caras[j] == caras[i]) ++j;
+        if (j - i == 1) {
+            const auto& c = caras[i];
+            claves.push_back((uint64_t)c[0] << 32 | c[1]);
+            claves.push_back((uint64_t)c[0] << 32 | c[2]);
+            claves.push_back((uint64_t)c[1] << 32 | c[2]);
+        }
+        i = j;
+    }
+    ordenarUnicoParalelo(claves);
+    part.bordeIndices.resize(claves.size() * 2);
+    for (size_t i = 0; i < claves.size(); ++i) {
+        part.bordeIndices[i * 2] = (GLuint)(claves[i] >> 32);
+        part.bordeIndices[i * 2 + 1] = (GLuint)(claves[i] & 0xffffffffu);
+    }
+}
+
+// Nivel reducido: lod/<nombre>.lodN.bin en la carpeta del .bin o .qbin de
+// la parte (ver test/simplificarMalla.cpp). Sus vértices son vértices
+// originales (los colapsos no mueven puntos), así que caben en la caja de
+// la parte y se cuantizan con ella.
+void cargarReducida(const std::string& ruta, ModelPart& part) {
+    part.puntosReducidos.clear();
+    part.aristasReducidas.clear();
+    std::filesystem::path archivo(ruta);
+    std::filesystem::path carpetaNiveles = archivo.parent_path() / "lod";
+    for (int nivel : NIVELES_REDUCIDOS) {
+        std::string rutaNivel = (carpetaNiveles / (archivo.stem().string() + ".lod" + std::to_string(nivel) + ".bin")).string();
+        if (!std::filesystem::exists(rutaNivel)) continue;
+        ModelPart reducida;
+        loadModel(rutaNivel, reducida);
+        part.puntosReducidos = std::move(reducida.points);
+        part.aristasReducidas = std::move(reducida.lineIndices);
+        for (auto& v : part.aristasReducidas) v += (GLuint)part.points.size();
+        return;
+    }
+}
+
+bool disponible(const ModelPart& part, Representacion r) {
+    switch (r) {
+        case REP_MUESTRA: return !part.muestraIndices.empty();
+        case REP_BORDE: return !part.bordeIndices.empty();
+        case REP_REDUCIDA: return !part.puntosReducidos.empty();
+        default: return true;
+    }
+}
+
+// Puntos + aristas que dibuja la representación
+size_t costo(const ModelPart& part, Representacion r) {
+    switch (r) {
+        case REP_MUESTRA: return part.muestraIndices.size();
+        case REP_BORDE: return part.bordeIndices.size() / 2;
+        case REP_REDUCIDA: return part.puntosReducidos.size() + part.aristasReducidas.size() / 2;
+        default: return part.points.size() + part.lineIndices.size() / 2;
+    }
+}
+
+// Usa cameraPos y fov del cuadro actual; las partes fuera del frustum
+// quedan en REP_COMPLETA y se descartan por bloques como siempre.
+void elegirRepresentaciones() {
+    struct Candidata { size_t parte; float px; };
+    std::vector<Candidata> candidatas;
+    size_t total = 0;
+    float tanMitad = std::tan(glm::radians(fov) * 0.5f);
+    for (size_t i = 0; i < modelParts.size(); ++i) {
+        ModelPart& part = modelParts[i];
+        part.representacion = REP_COMPLETA;
+        if (!lodActivo || !part.visible || !part.cargada || !disponible(part, REP_MUESTRA)) continue;
+        if (!cajaVisible(part.caja, part.escala, part.desplazamiento)) continue;
+
+        // Diámetro aparente de la esfera que envuelve la caja
+        glm::vec3 a = part.caja.min * part.escala + part.desplazamiento;
+        glm::vec3 b = part.caja.max * part.escala + part.desplazamiento;
+        float r = glm::length(b - a) * 0.5f;
+        float d = glm::length(cameraPos - (a + b) * 0.5f);
+        float px = d > r ? r / std::sqrt(d * d - r * r) / tanMitad * ALTO_VENTANA_PX : INFINITY;
+        if ((int)i == parteSeleccionada) px = INFINITY;
+
+        part.representacion = REP_MUESTRA;
+        total += costo(part, REP_MUESTRA);
+        candidatas.push_back({i, px});
+    }
+    std::stable_sort(candidatas.begin(), candidatas.end(),
+                     [](const Candidata& x, const Candidata& y) { return x.px > y.px; });
+
+    for (const auto& c : candidatas) {
+        ModelPart& part = modelParts[c.parte];
+        Representacion pedida = c.px >= PX_COMPLETA ? REP_COMPLETA : c.px >= PX_REDUCIDA ? REP_REDUCIDA
+                              : c.px >= PX_BORDE ? REP_BORDE : REP_MUESTRA;
+        for (int r = pedida; r > part.representacion; --r) {
+            Representacion rep = (Representacion)r;
+            if (!disponible(part, rep)) continue;
+            size_t nuevo = total - costo(part, part.representacion) + costo(part, rep);
+            if (nuevo > presupuestoPrimitivas) continue;
+            total = nuevo;
+            part.representacion = rep;
+            break;
+        }
+    }
+}
+
+// ==================== Buffers de escena ====================
+// Arma los rangos de dibujo con las partes visibles y los bloques que tocan
+// el frustum (los rangos contiguos de una misma parte se fusionan); no sube
+// nada a la GPU. Las partes en una representación reducida van enteras.
+void actualizarRangosDibujo() {
+    dibujo.limpiar();
+    muestraOffsets.clear(); muestraCounts.clear(); muestraBaseVertex.clear();
+    tramosParte.clear();
+    estadisticas = {};
+
+    for (size_t i = 0; i < modelParts.size(); ++i) {
+        const auto& part = modelParts[i];
+        if (!part.visible || !part.cargada) continue;
+        TramoParte tramo{i, dibujo.pointFirsts.size(), 0, dibujo.lineCounts.size(), 0, muestraCounts.size(), 0};
+        dibujo.cortarTramos();
+        ++estadisticas.partesPorRepresentacion[part.representacion];
+
+        if (part.representacion == REP_MUESTRA) {
+            muestraOffsets.push_back((const void*)((part.firstLine + part.firstMuestra) * sizeof(GLuint)));
+            muestraCounts.push_back((GLsizei)part.muestraIndices.size());
+            muestraBaseVertex.push_back((GLint)part.firstPoint);
+            estadisticas.puntosDibujados += part.muestraIndices.size();
+        } else if (part.representacion == REP_BORDE) {
+            dibujo.agregarAristas(part.firstLine + part.firstBorde, part.bordeIndices.size(), part.firstPoint);
+            estadisticas.aristasDibujadas += part.bordeIndices.size() / 2;
+        } else if (part.representacion == REP_REDUCIDA) {
+            dibujo.agregarPuntos(part.firstPoint + part.points.size(), part.puntosReducidos.size());
+            dibujo.agregarAristas(part.firstLine + part.firstReducida, part.aristasReducidas.size(), part.firstPoint);
+            estadisticas.puntosDibujados += part.puntosReducidos.size();
+            estadisticas.aristasDibujadas += part.aristasReducidas.size() / 2;
+        } else {
+            agregarBloquesVisibles(part.bloques, part.firstPoint, part.firstLine, cajaVisible(part.caja, part.escala, part.desplazamiento),
+                                   [&](const AABB& c) { return cajaVisible(c, part.escala, part.desplazamiento); }, dibujo, estadisticas);
+        }
+
+        tramo.nPuntos = dibujo.pointFirsts.size() - tramo.primerPunto;
+        tramo.nAristas = dibujo.lineCounts.size() - tramo.primeraArista;
+        tramo.nMuestras = muestraCounts.size() - tramo.primeraMuestra;
+        if (tramo.nPuntos + tramo.nAristas + tramo.nMuestras > 0) tramosParte.push_back(tramo);
+        else --estadisticas.partesPorRepresentacion[part.representacion];
+    }
+}
+
+// Sube colores y afines por parte. Reencuadrar o agregar un órgano sólo
+// requiere normalizarGlobal + esta función, sin tocar los vértices. Con
+// vértices cuantizados la afín arranca desde [0, 1] de la caja de la parte,
+// así que se vuelve a llamar cuando llegan partes nuevas.
+void actualizarBloquePartes() {
+    std::vector<glm::vec4> bloque(3 * MAX_PARTES, glm::vec4(0.0f));
+    for (size_t i = 0; i < modelParts.size(); ++i) {
+        const ModelPart& part = modelParts[i];
+        glm::vec3 escala = part.escala, desp = part.desplazamiento;
+        if (verticesCuantizados && part.cargada) {
+            desp = part.caja.min * escala + desp;
+            escala = (part.caja.max - part.caja.min) * escala;
+        }
+        bloque[i] = glm::vec4(part.color, 1.0f);
+        bloque[MAX_PARTES + i] = glm::vec4(escala, 0.0f);
+        bloque[2 * MAX_PARTES + i] = glm::vec4(desp, 0.0f);
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, UBO_partes);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, bloque.size() * sizeof(glm::vec4), bloque.data());
+}
+
+// Los buffers de escena arrancan vacíos y crecen a medida que llegan las
+// partes (ver "Carga en paralelo"); el bloque de partes ya queda completo,
+// porque la afín de cada parte sólo depende de los rangos.
+void crearBuffersEscena() {
+    crearEscena(modelParts.size(), shaderProgram, "Partes", 3 * MAX_PARTES * sizeof(glm::vec4), VAO_scene, UBO_partes);
+    actualizarBloquePartes();
+}
 
-        part.lineCount = lineData.size() / 3;
+// ==================== Carga en paralelo ====================
+// Ver escenaComun.h; cada parte se lee, indexa, reordena (construirBloques)
+// y empaqueta en los hilos del cargador.
+// Vértices de la parte (`points` y después `puntosReducidos`) en el formato de VBO_scene
+std::vector<unsigned char> empaquetarVertices(const ModelPart& part, size_t i) {
+    size_t n = part.points.size() + part.puntosReducidos.size();
+    auto punto = [&](size_t j) -> const Point& {
+        return j < part.points.size() ? part.points[j] : part.puntosReducidos[j - part.points.size()];
+    };
+    std::vector<unsigned char> bytes(n * tamVertice());
+    if (!verticesCuantizados) {
+        Vertice* v = reinterpret_cast<Vertice*>(bytes.data());
+        for (size_t j = 0; j < n; ++j) {
+            const Point& p = punto(j);
+            v[j] = {(float)p.x, (float)p.y, (float)p.z, (GLuint)i};
+        }
+        return bytes;
+    }
+    VerticeCuantizado* v = reinterpret_cast<VerticeCuantizado*>(bytes.data());
+    glm::vec3 ext = part.caja.max - part.caja.min;
+    auto q = [](double c, float mn, float ext) {
+        double t = ext > 0.0f ? (c - mn) / ext : 0.0;
+        return (GLushort)std::lround(std::min(std::max(t, 0.0), 1.0) * 65535.0);
+    };
+    for (size_t j = 0; j < n; ++j) {
+        const Point& p = punto(j);
+        v[j] = {q(p.x, part.caja.min.x, ext.x), q(p.y, part.caja.min.y, ext.y), q(p.z, part.caja.min.z, ext.z), (GLushort)i};
+    }
+    return bytes;
+}
+
+// Corre en los hilos del cargador
+void decodificarParte(size_t i, const std::string& ruta, ParteLista& lista) {
+    ModelPart& part = modelParts[i];
+    loadModel(ruta, part);
+    construirBloques(part.points, part.lineIndices, {&part.tetIndices, &part.bordeIndices}, part.caja, part.bloques);
+    construirIntervalos(part);
+    construirRepresentaciones(part);
+    cargarReducida(ruta, part);
+    lista.vertices = empaquetarVertices(part, i);
+
+    auto& ind = lista.indices;
+    ind = part.lineIndices;
+    part.firstMuestra = ind.size();
+    ind.insert(ind.end(), part.muestraIndices.begin(), part.muestraIndices.end());
+    part.firstBorde = ind.size();
+    ind.insert(ind.end(), part.bordeIndices.begin(), part.bordeIndices.end());
+    part.firstReducida = ind.size();
+    ind.insert(ind.end(), part.aristasReducidas.begin(), part.aristasReducidas.end());
+}
+
+void descartarParte(size_t i) {
+    ModelPart& part = modelParts[i];
+    part.points.clear(); part.lineIndices.clear(); part.tetIndices.clear(); part.bloques.clear();
+    for (auto& c : part.intervalos) c.clear();
+    part.muestraIndices.clear(); part.bordeIndices.clear();
+    part.puntosReducidos.clear(); part.aristasReducidas.clear();
+    part.pointCount = part.lineCount = 0;
+}
+
+CargadorPartes cargador;
+
+void enlazarBuffersEscena() {
+    glBindVertexArray(VAO_scene);
+    glBindBuffer(GL_ARRAY_BUFFER, escena.vbo);
+    if (verticesCuantizados) {
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(VerticeCuantizado), (void*)0);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_SHORT, sizeof(VerticeCuantizado), (void*)offsetof(VerticeCuantizado, parte));
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertice), (void*)0);
+        glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertice), (void*)offsetof(Vertice, parte));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, escena.ebo);
+    glBindVertexArray(0);
+}
+
+// Devuelve cuántas partes subió
+size_t subirPartes(size_t maxBytes) {
+    size_t n = subirPartesListas(cargador, escena, tamVertice(), maxBytes,
+        [](size_t i, size_t firstPoint, size_t firstLine) {
+            ModelPart& part = modelParts[i];
+            part.firstPoint = firstPoint;
+            part.firstLine = firstLine;
+            part.cargada = true;
+        }, enlazarBuffersEscena);
+    if (verticesCuantizados && n > 0) actualizarBloquePartes();
+    if (n > 0) corteSucio = true;
+    return n;
+}
+
+// ==================== Tiempos de cuadro ====================
+// Consultas GL_TIME_ELAPSED por pasada en un anillo de CUADROS_EN_VUELO
+// cuadros. El resultado de un cuadro se lee cuando le vuelve a tocar su
+// lugar en el anillo y sólo si ya está disponible; si no, se descarta, así
+// que nunca se espera a la GPU.
+const int CUADROS_EN_VUELO = 4;
+const int HISTORIAL_CUADROS = 240;
+const float ESCALA_GRAFICO_MS = 33.3f; // Alto completo del gráfico
+
+class TemporizadorGPU {
+public:
+    std::vector<std::pair<std::string, double>> ultimo; // Pasadas del último cuadro leído, en ms
+    double ultimoTotal = 0.0;
+    bool hayNuevo = false;
+
+    void comenzarCuadro() {
+        actual = (actual + 1) % CUADROS_EN_VUELO;
+        recoger(cuadros[actual]);
+        cuadros[actual].usadas = 0;
+    }
+
+    void comenzar(const std::string& nombre) {
+        Cuadro& c = cuadros[actual];
+        if (c.usadas == c.consultas.size()) {
+            GLuint q;
+            glGenQueries(1, &q);
+            c.consultas.push_back(q);
+            c.nombres.emplace_back();
+        }
+        c.nombres[c.usadas] = nombre;
+        glBeginQuery(GL_TIME_ELAPSED, c.consultas[c.usadas++]);
+    }
+
+    void terminar() { glEndQuery(GL_TIME_ELAPSED); }
+
+    void liberar() {
+        for (auto& c : cuadros) {
+            glDeleteQueries(c.consultas.size(), c.consultas.data());
+            c.consultas.clear();
+        }
+    }
+
+private:
+    struct Cuadro {
+        std::vector<GLuint> consultas;
+        std::vector<std::string> nombres;
+        size_t usadas = 0;
+    };
+    Cuadro cuadros[CUADROS_EN_VUELO];
+    int actual = 0;
+
+    void recoger(const Cuadro& c) {
+        if (c.usadas == 0) return;
+        GLint listo = 0;
+        glGetQueryObjectiv(c.consultas[c.usadas - 1], GL_QUERY_RESULT_AVAILABLE, &listo);
+        if (!listo) return;
+        ultimo.clear();
+        ultimoTotal = 0.0;
+        for (size_t i = 0; i < c.usadas; ++i) {
+            GLuint64 ns = 0;
+            glGetQueryObjectui64v(c.consultas[i], GL_QUERY_RESULT, &ns);
+            ultimo.emplace_back(c.nombres[i], ns / 1e6);
+            ultimoTotal += ns / 1e6;
+        }
+        hayNuevo = true;
+    }
+};
+
+double msDesde(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+TemporizadorGPU temporizador;
+bool mostrarOverlay = true;
+bool medirPorParte = false;
+size_t llamadasDibujo = 0;
+std::ofstream csvTiempos;       // Abierto sólo con --csv
+uint64_t cuadroCsv = 0;
+
+std::vector<float> historialCpu(HISTORIAL_CUADROS, 0.0f), historialGpu(HISTORIAL_CUADROS, 0.0f);
+int posHistorial = 0;
+GLuint VAO_overlay, VBO_overlay;
+
+void crearOverlay() {
+    shaderOverlay = compileShader(overlayVertexShaderSource, overlayFragmentShaderSource);
+    glGenVertexArrays(1, &VAO_overlay);
+    glGenBuffers(1, &VBO_overlay);
+    glBindVertexArray(VAO_overlay);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_overlay);
+    glBufferData(GL_ARRAY_BUFFER, (HISTORIAL_CUADROS + 2) * sizeof(glm::vec2), nullptr, GL_STREAM_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+}
+
+// Guarda el tiempo de CPU del cuadro y, cuando llega, el de GPU de uno anterior.
+void registrarTiempos(double cpuMs) {
+    historialCpu[posHistorial] = (float)cpuMs;
+    if (temporizador.hayNuevo) historialGpu[posHistorial] = (float)temporizador.ultimoTotal;
+    else historialGpu[posHistorial] = historialGpu[(posHistorial + HISTORIAL_CUADROS - 1) % HISTORIAL_CUADROS];
+    posHistorial = (posHistorial + 1) % HISTORIAL_CUADROS;
+
+    if (csvTiempos.is_open()) {
+        csvTiempos << cuadroCsv << ",cpu," << cpuMs << "\n";
+        if (temporizador.hayNuevo)
+            for (const auto& [nombre, ms] : temporizador.ultimo) csvTiempos << cuadroCsv << "," << nombre << "," << ms << "\n";
+        ++cuadroCsv;
+    }
+    temporizador.hayNuevo = false;
+}
+
+// Dos curvas (CPU en gris, GPU en rojo) y una línea en 16.6 ms, abajo a la izquierda.
+void dibujarOverlay() {
+    auto y = [](float ms) { return -0.95f + 0.4f * std::min(ms / ESCALA_GRAFICO_MS, 1.0f); };
+    std::vector<glm::vec2> linea(HISTORIAL_CUADROS);
+
+    glDisable(GL_DEPTH_TEST);
+    glUseProgram(shaderOverlay);
+    glBindVertexArray(VAO_overlay);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_overlay);
+    GLint color = glGetUniformLocation(shaderOverlay, "color");
+
+    glm::vec2 referencia[2] = {{-0.95f, y(16.6f)}, {-0.35f, y(16.6f)}};
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(referencia), referencia);
+    glUniform3f(color, 0.2f, 0.7f, 0.2f);
+    glDrawArrays(GL_LINES, 0, 2);
+
+    for (int serie = 0; serie < 2; ++serie) {
+        const auto& h = serie == 0 ? historialCpu : historialGpu;
+        for (int i = 0; i < HISTORIAL_CUADROS; ++i)
+            linea[i] = {-0.95f + 0.6f * i / (HISTORIAL_CUADROS - 1), y(h[(posHistorial + i) % HISTORIAL_CUADROS])};
+        glBufferSubData(GL_ARRAY_BUFFER, 0, linea.size() * sizeof(glm::vec2), linea.data());
+        if (serie == 0) glUniform3f(color, 0.4f, 0.4f, 0.4f);
+        else glUniform3f(color, 0.9f, 0.1f, 0.1f);
+        glDrawArrays(GL_LINE_STRIP, 0, HISTORIAL_CUADROS);
+    }
+    glBindVertexArray(0);
+    glEnable(GL_DEPTH_TEST);
+}
+
+// Flechas: elegir parte, espacio: mostrar/ocultar, 0: mostrar todas,
+// F1: gráfico de tiempos, T: medir la GPU por parte, P: modo progresivo,
+// C: eje del corte, V: lado del corte, L: nivel de detalle.
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action != GLFW_PRESS || modelParts.empty()) return;
+    redibujar = true;
+    if (key == GLFW_KEY_P) {
+        modoProgresivo = !modoProgresivo;
+        std::cout << "Modo progresivo: " << (modoProgresivo ? "si" : "no") << "\n";
+        return;
+    }
+    if (key == GLFW_KEY_F1) { mostrarOverlay = !mostrarOverlay; return; }
+    if (key == GLFW_KEY_T) {
+        medirPorParte = !medirPorParte;
+        std::cout << "Tiempos por parte: " << (medirPorParte ? "si" : "no") << "\n";
+        return;
+    }
+    if (key == GLFW_KEY_C) {
+        ejeCorte = ejeCorte == 2 ? -1 : ejeCorte + 1;
+        corteSucio = true;
+        if (ejeCorte < 0) arrastrandoCorte = false;
+        std::cout << "Corte: " << (ejeCorte < 0 ? "no" : std::string(1, "XYZ"[ejeCorte])) << "\n";
+        return;
+    }
+    if (key == GLFW_KEY_V) { ladoCorte = -ladoCorte; return; }
+    if (key == GLFW_KEY_L) {
+        lodActivo = !lodActivo;
+        std::cout << "Nivel de detalle: " << (lodActivo ? "si" : "no") << "\n";
+        return;
     }
+    if (teclaPartes(key, modelParts, parteSeleccionada)) corteSucio = true;
+}
+
+// Puntos, muestras y aristas de las partes visibles; con `tiempos` y
+// medirPorParte, hasta tres llamadas por parte con una consulta por parte.
+void dibujarEscena(TemporizadorGPU* tiempos, bool soloPuntos) {
+    glBindVertexArray(VAO_scene);
+    if (tiempos && medirPorParte) {
+        for (const auto& t : tramosParte) {
+            tiempos->comenzar(modelParts[t.parte].nombre);
+            glMultiDrawArrays(GL_POINTS, dibujo.pointFirsts.data() + t.primerPunto, dibujo.pointCounts.data() + t.primerPunto, t.nPuntos);
+            glMultiDrawElementsBaseVertex(GL_POINTS, muestraCounts.data() + t.primeraMuestra, GL_UNSIGNED_INT,
+                                          muestraOffsets.data() + t.primeraMuestra, t.nMuestras,
+                                          muestraBaseVertex.data() + t.primeraMuestra);
+            if (!soloPuntos)
+                glMultiDrawElementsBaseVertex(GL_LINES, dibujo.lineCounts.data() + t.primeraArista, GL_UNSIGNED_INT,
+                                              dibujo.lineOffsets.data() + t.primeraArista, t.nAristas,
+                                              dibujo.lineBaseVertex.data() + t.primeraArista);
+            tiempos->terminar();
+        }
+        llamadasDibujo = (soloPuntos ? 2 : 3) * tramosParte.size();
+        return;
+    }
+
+    // Una sola llamada por primitiva para todas las partes visibles
+    if (tiempos) tiempos->comenzar("puntos");
+    glMultiDrawArrays(GL_POINTS, dibujo.pointFirsts.data(), dibujo.pointCounts.data(), dibujo.pointFirsts.size());
+    if (tiempos) tiempos->terminar();
+    llamadasDibujo = 1;
+    if (!muestraCounts.empty()) {
+        if (tiempos) tiempos->comenzar("muestras");
+        glMultiDrawElementsBaseVertex(GL_POINTS, muestraCounts.data(), GL_UNSIGNED_INT, muestraOffsets.data(),
+                                      muestraCounts.size(), muestraBaseVertex.data());
+        if (tiempos) tiempos->terminar();
+        ++llamadasDibujo;
+    }
+    if (soloPuntos) return;
+
+    if (tiempos) tiempos->comenzar("aristas");
+    glMultiDrawElementsBaseVertex(GL_LINES, dibujo.lineCounts.data(), GL_UNSIGNED_INT, dibujo.lineOffsets.data(),
+                                  dibujo.lineCounts.size(), dibujo.lineBaseVertex.data());
+    if (tiempos) tiempos->terminar();
+    ++llamadasDibujo;
+}
+
+// Cámara orbital + culling + las llamadas de dibujo. Compartido por la
+// ventana interactiva y el benchmark headless; este último mide el cuadro
+// entero por su cuenta y pasa `tiempos` nulo (las consultas no se anidan).
+// Con `soloPuntos` se omiten las aristas (cuadro reducido del modo progresivo).
+void dibujarCuadro(TemporizadorGPU* tiempos = nullptr, bool soloPuntos = false) {
+    glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    cameraPos.x = radius * cos(glm::radians(yaw)) * cos(glm::radians(pitch));
+    cameraPos.y = radius * sin(glm::radians(pitch));
+    cameraPos.z = radius * sin(glm::radians(yaw)) * cos(glm::radians(pitch));
+
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), cameraUp);
+    glm::mat4 proj = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 200.0f);
+
+    extraerPlanosFrustum(proj * view * model);
+    elegirRepresentaciones();
+    actualizarRangosDibujo();
+
+    glUseProgram(shaderProgram);
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
+
+    if (ejeCorte < 0) {
+        dibujarEscena(tiempos, soloPuntos);
+        return;
+    }
+
+    // La sección va sin recortar: está justo sobre el plano
+    if (corteSucio) actualizarCorte();
+    if (tiempos) tiempos->comenzar("corte");
+    glBindVertexArray(VAO_corte);
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)verticesCorte);
+    if (tiempos) tiempos->terminar();
+
+    glm::vec4 plano(0.0f);
+    plano[ejeCorte] = ladoCorte;
+    plano.w = -ladoCorte * posCorte;
+    glUniform4fv(glGetUniformLocation(shaderProgram, "planoCorte"), 1, glm::value_ptr(plano));
+    glEnable(GL_CLIP_DISTANCE0);
+    dibujarEscena(tiempos, soloPuntos);
+    glDisable(GL_CLIP_DISTANCE0);
+    ++llamadasDibujo;
 }
 
 void renderLoop(GLFWwindow* window) {
+    crearOverlay();
+    double ultimoTitulo = 0.0;
     while (!glfwWindowShouldClose(window)) {
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        cameraPos.x = radius * cos(glm::radians(yaw)) * cos(glm::radians(pitch));
-        cameraPos.y = radius * sin(glm::radians(pitch));
-        cameraPos.z = radius * sin(glm::radians(yaw)) * cos(glm::radians(pitch));
-
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), cameraUp);
-        glm::mat4 proj = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 200.0f);
-
-        glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
-
-        for (auto& part : modelParts) {
-            glUniform3fv(glGetUniformLocation(shaderProgram, "uColor"), 1, glm::value_ptr(part.color));
-
-            // Puntos
-            glBindVertexArray(part.VAO_points);
-            glPointSize(3.0f);
-            glDrawArrays(GL_POINTS, 0, part.pointCount);
-
-            // Aristas
-            glBindVertexArray(part.VAO_lines);
-            glLineWidth(1.0f);
-            glDrawArrays(GL_LINES, 0, part.lineCount);
+        // Lo que terminaron los hilos del cargador entra antes de dibujar
+        if (subirPartes(MAX_BYTES_SUBIDA) > 0) {
+            redibujar = true;
+            if (!cargador.pendientes()) std::cout << "Carga completa: " << cargador.msCarga() << " ms\n";
+        }
+
+        bool moviendo = glfwGetTime() - ultimoMovimiento < QUIETUD_S;
+        if (redibujar || (cuadroReducido && !moviendo)) {
+            bool reducido = modoProgresivo && moviendo;
+            auto t0 = std::chrono::steady_clock::now();
+            temporizador.comenzarCuadro();
+            dibujarCuadro(&temporizador, reducido);
+            if (mostrarOverlay) dibujarOverlay();
+            registrarTiempos(msDesde(t0));
+            glfwSwapBuffers(window);
+            redibujar = false;
+            cuadroReducido = reducido;
+
+            if (glfwGetTime() - ultimoTitulo > 0.5) {
+                ultimoTitulo = glfwGetTime();
+                int ultimo = (posHistorial + HISTORIAL_CUADROS - 1) % HISTORIAL_CUADROS;
+                std::ostringstream titulo;
+                titulo.precision(3);
+                titulo << "CPU " << historialCpu[ultimo] << " ms | GPU " << historialGpu[ultimo] << " ms | "
+                       << llamadasDibujo << " llamadas | Puntos " << estadisticas.puntosDibujados
+                       << " (descartados " << estadisticas.puntosDescartados << ") | Aristas " << estadisticas.aristasDibujadas
+                       << " (descartadas " << estadisticas.aristasDescartadas << ")";
+                if (lodActivo) {
+                    const size_t* r = estadisticas.partesPorRepresentacion;
+                    titulo << " | LOD muestra/borde/reducida/completa " << r[REP_MUESTRA] << "/" << r[REP_BORDE]
+                           << "/" << r[REP_REDUCIDA] << "/" << r[REP_COMPLETA];
+                }
+                if (ejeCorte >= 0)
+                    titulo << " | Corte " << "XYZ"[ejeCorte] << " " << posCorte << ": " << verticesCorte / 3
+                           << " triángulos de " << tetsCandidatos << " tetraedros en " << msCorte << " ms";
+                glfwSetWindowTitle(window, titulo.str().c_str());
+            }
         }
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+        // Sin cambios el hilo duerme; si falta el cuadro completo, despierta a
+        // tiempo, y si quedaron partes listas por subir no espera.
+        if (cargador.hayListas()) glfwPollEvents();
+        else glfwWaitEventsTimeout(cuadroReducido ? QUIETUD_S : 0.5);
     }
+    temporizador.liberar();
+}
+
+// ==================== Benchmark headless ====================
+// viTeta --headless [--frames N] [--orbit] [--flotante] [--presupuesto N] [--sin-lod]
+// Dibuja N cuadros en un FBO fuera de pantalla (contexto OSMesa/EGL, sirve
+// con llvmpipe) y escribe en stdout un JSON con los tiempos de carga y,
+// por cuadro, el tiempo de CPU y el de GPU (GL_TIME_ELAPSED). Los mensajes
+// de carga van a stderr para no mezclarse con el JSON.
+// Con --superficies carga las superficies de output/superficies (ver
+// test/superficieMascaras.cpp) en lugar de las mallas de tetraedros.
+// --presupuesto fija las primitivas por cuadro del nivel de detalle y
+// --sin-lod arranca con todas las partes completas.
+struct Opciones {
+    bool headless = false;
+    int frames = 300;
+    bool orbit = false;
+    std::string csv;   // --csv archivo: tiempos por pasada de la ventana interactiva
+    bool flotante = false;
+    bool superficies = false;
+    size_t presupuesto = PRESUPUESTO_POR_DEFECTO;
+    bool sinLod = false;
+};
+
+Opciones leerOpciones(int argc, char** argv) {
+    Opciones op;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--headless") op.headless = true;
+        else if (a == "--orbit") op.orbit = true;
+        else if (a == "--frames" && i + 1 < argc) op.frames = std::max(1, std::stoi(argv[++i]));
+        else if (a == "--csv" && i + 1 < argc) op.csv = argv[++i];
+        else if (a == "--flotante") op.flotante = true;
+        else if (a == "--superficies") op.superficies = true;
+        else if (a == "--presupuesto" && i + 1 < argc) op.presupuesto = std::stoull(argv[++i]);
+        else if (a == "--sin-lod") op.sinLod = true;
+        else throw std::runtime_error("Argumento desconocido: " + a);
+    }
+    return op;
+}
+
+// Sin display: plataforma nula de GLFW (3.4+) y contexto OSMesa, con EGL
+// como segunda opción.
+GLFWwindow* crearContextoHeadless() {
+#ifdef GLFW_PLATFORM_NULL
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+    if (!glfwInit()) return nullptr;
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    for (int api : {GLFW_OSMESA_CONTEXT_API, GLFW_EGL_CONTEXT_API}) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+        if (GLFWwindow* w = glfwCreateWindow(800, 600, "Visualizador Rana 3D", NULL, NULL)) return w;
+    }
+    return nullptr;
+}
+
+double percentil(std::vector<double> v, double p) {
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+void benchmarkHeadless(const Opciones& op, const std::vector<std::pair<std::string, double>>& tiemposCarga) {
+    GLuint fbo, rb[2];
+    glGenFramebuffers(1, &fbo);
+    glGenRenderbuffers(2, rb);
+    glBindRenderbuffer(GL_RENDERBUFFER, rb[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, 800, 600);
+    glBindRenderbuffer(GL_RENDERBUFFER, rb[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 800, 600);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rb[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rb[1]);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        throw std::runtime_error("FBO headless incompleto");
+    glViewport(0, 0, 800, 600);
+
+    // Una consulta por cuadro; se leen todas al final para no frenar el pipeline
+    std::vector<GLuint> consultas(op.frames);
+    glGenQueries(op.frames, consultas.data());
+    std::vector<double> cpuMs(op.frames), gpuMs(op.frames);
+    std::vector<Estadisticas> stats(op.frames);
+
+    for (int i = 0; i < op.frames; ++i) {
+        if (op.orbit) {
+            // Una vuelta completa acercándose y alejándose, para ejercitar el culling
+            float t = glm::radians(360.0f * i / op.frames);
+            yaw = -90.0f + 360.0f * i / op.frames;
+            pitch = 30.0f * std::sin(t);
+            radius = 6.0f + 4.0f * std::cos(t);
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, consultas[i]);
+        dibujarCuadro();
+        glEndQuery(GL_TIME_ELAPSED);
+        glFlush();
+        cpuMs[i] = msDesde(t0);
+        stats[i] = estadisticas;
+    }
+    glFinish();
+    for (int i = 0; i < op.frames; ++i) {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(consultas[i], GL_QUERY_RESULT, &ns);
+        gpuMs[i] = ns / 1e6;
+    }
+    glDeleteQueries(op.frames, consultas.data());
+    glDeleteRenderbuffers(2, rb);
+    glDeleteFramebuffers(1, &fbo);
+
+    std::ostringstream js;
+    js << "{\n  \"carga_ms\": {";
+    for (size_t i = 0; i < tiemposCarga.size(); ++i)
+        js << (i ? ", " : "") << "\"" << tiemposCarga[i].first << "\": " << tiemposCarga[i].second;
+    js << "},\n  \"orbit\": " << (op.orbit ? "true" : "false")
+       << ",\n  \"cuantizado\": " << (verticesCuantizados ? "true" : "false")
+       << ",\n  \"lod\": " << (lodActivo ? "true" : "false")
+       << ",\n  \"vram_bytes\": " << escena.puntos * tamVertice() + escena.aristas * sizeof(GLuint)
+       << ",\n  \"cuadros\": [\n";
+    for (int i = 0; i < op.frames; ++i) {
+        js << "    {\"cpu_ms\": " << cpuMs[i] << ", \"gpu_ms\": " << gpuMs[i]
+           << ", \"puntos\": " << stats[i].puntosDibujados << ", \"aristas\": " << stats[i].aristasDibujadas << "}"
+           << (i + 1 < op.frames ? ",\n" : "\n");
+    }
+    js << "  ],\n  \"resumen\": {"
+       << "\"cpu_ms_p50\": " << percentil(cpuMs, 0.5) << ", \"cpu_ms_p95\": " << percentil(cpuMs, 0.95)
+       << ", \"gpu_ms_p50\": " << percentil(gpuMs, 0.5) << ", \"gpu_ms_p95\": " << percentil(gpuMs, 0.95)
+       << "}\n}\n";
+    std::cout << js.str();
 }
 
 // ==================== MAIN ====================
-int main() {
+int main(int argc, char** argv) {
     try {
-        if (!glfwInit()) return -1;
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-        GLFWwindow* window = glfwCreateWindow(800, 600, "Visualizador Rana 3D", NULL, NULL);
-        if (!window) { glfwTerminate(); return -1; }
-        glfwMakeContextCurrent(window);
-
-        glfwSetCursorPosCallback(window, mouse_callback);
-        glfwSetScrollCallback(window, scroll_callback);
-        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        Opciones opciones = leerOpciones(argc, argv);
+        verticesCuantizados = !opciones.flotante;
+        lodActivo = !opciones.sinLod;
+        presupuestoPrimitivas = opciones.presupuesto;
+        std::ostream& log = opciones.headless ? std::cerr : std::cout;
+        std::vector<std::pair<std::string, double>> tiemposCarga;
+        auto t0 = std::chrono::steady_clock::now();
+
+        GLFWwindow* window;
+        if (opciones.headless) {
+            window = crearContextoHeadless();
+            if (!window) { std::cerr << "No se pudo crear un contexto headless\n"; glfwTerminate(); return -1; }
+            glfwMakeContextCurrent(window);
+        } else {
+            if (!glfwInit()) return -1;
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+            window = glfwCreateWindow(800, 600, "Visualizador Rana 3D", NULL, NULL);
+            if (!window) { glfwTerminate(); return -1; }
+            glfwMakeContextCurrent(window);
+
+            glfwSetCursorPosCallback(window, mouse_callback);
+            glfwSetScrollCallback(window, scroll_callback);
+            glfwSetMouseButtonCallback(window, mouse_button_callback);
+            glfwSetKeyCallback(window, key_callback);
+            glfwSetWindowRefreshCallback(window, refresh_callback);
+            glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        }
 
         gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
         glEnable(GL_DEPTH_TEST);
+        glPointSize(3.0f);
+        glLineWidth(1.0f);
 
         shaderProgram = compileShader(vertexShaderSource, fragmentShaderSource);
+        tiemposCarga.emplace_back("contexto", msDesde(t0));
 
         std::vector<std::string> archivosTxt = {
             "puntos_tiff_bloodMasks.txt", "puntos_tiff_brainMasks.txt",
@@ -299,24 +1319,83 @@ int main() {
             "puntos_tiff_lungMasks_grupo2.txt"
         };
 
-        cargarRangosOriginales(archivosTxt, "puntos_separados");
-
-        for (const auto& nombre : archivosTxt) {
-            std::string baseName = nombre.substr(0, nombre.find_last_of("."));
-            std::string rutaBin = "output/" + baseName + ".txt.bin";
-
-            if (std::filesystem::exists(rutaBin)) {
+        // Las partes se registran con su rango y color; la geometría llega después
+        std::vector<std::string> rutasBin;
+        std::mt19937 gen{ std::random_device{}() };
+        std::uniform_real_distribution<float> dist(0.2f, 1.0f);
+        if (opciones.superficies) {
+            // Todas vienen normalizadas con la misma caja (la del volumen de
+            // máscaras), así que comparten rango y la afín de cada una es la identidad
+            const std::string carpeta = "output/superficies";
+            if (std::filesystem::is_directory(carpeta))
+                for (auto& entry : std::filesystem::directory_iterator(carpeta))
+                    if (entry.path().extension() == ".qbin") rutasBin.push_back(entry.path().string());
+            std::sort(rutasBin.begin(), rutasBin.end());
+            if (rutasBin.empty()) throw std::runtime_error("No hay superficies en " + carpeta);
+            for (const auto& ruta : rutasBin) {
                 ModelPart part;
-                loadModel(rutaBin, part, rangos[nombre]);
+                part.nombre = std::filesystem::path(ruta).stem().string();
+                part.rango = {-1.0, 1.0, -1.0, 1.0, -1.0, 1.0};
+                part.color = glm::vec3(dist(gen), dist(gen), dist(gen));
                 modelParts.push_back(part);
-                std::cout << "Cargado: " << rutaBin << "\n";
-            } else {
-                std::cerr << "No encontrado: " << rutaBin << "\n";
             }
+        } else {
+            t0 = std::chrono::steady_clock::now();
+            cargarRangosOriginales(archivosTxt, "puntos_separados");
+            tiemposCarga.emplace_back("rangos", msDesde(t0));
+
+            for (const auto& nombre : archivosTxt) {
+                std::string baseName = nombre.substr(0, nombre.find_last_of("."));
+                std::string rutaBin = "output/" + baseName + ".txt.bin";
+                std::string rutaQbin = "output/" + baseName + ".txt.qbin";
+                // El .qbin sale del .bin: si el .bin es más nuevo, el .qbin quedó viejo
+                if (std::filesystem::exists(rutaQbin)) {
+                    if (!std::filesystem::exists(rutaBin) ||
+                        std::filesystem::last_write_time(rutaQbin) >= std::filesystem::last_write_time(rutaBin))
+                        rutaBin = rutaQbin;
+                    else
+                        std::cerr << "Aviso: " << rutaQbin << " es más viejo que el .bin, se usa el .bin\n";
+                }
+
+                if (std::filesystem::exists(rutaBin)) {
+                    ModelPart part;
+                    part.nombre = baseName;
+                    part.rango = rangos[nombre];
+                    part.color = glm::vec3(dist(gen), dist(gen), dist(gen));
+                    modelParts.push_back(part);
+                    rutasBin.push_back(rutaBin);
+                } else {
+                    std::cerr << "No encontrado: " << rutaBin << "\n";
+                }
+            }
+        }
+
+        normalizarGlobal(modelParts);
+        crearBuffersEscena();
+        cargador.log = &log;
+        cargador.iniciar(rutasBin, decodificarParte, descartarParte);
+
+        if (!opciones.csv.empty()) {
+            csvTiempos.open(opciones.csv);
+            if (!csvTiempos) throw std::runtime_error("No se pudo escribir: " + opciones.csv);
+            csvTiempos << "cuadro,pasada,ms\n";
         }
 
-        normalizarGlobal();
-        renderLoop(window);
+        if (opciones.headless) {
+            // El benchmark arranca con todas las partes en la GPU
+            t0 = std::chrono::steady_clock::now();
+            while (cargador.pendientes()) {
+                cargador.esperar();
+                subirPartes(SIZE_MAX);
+            }
+            glFinish();
+            tiemposCarga.emplace_back("modelos", cargador.msCarga());
+            tiemposCarga.emplace_back("subida", msDesde(t0));
+            benchmarkHeadless(opciones, tiemposCarga);
+        } else {
+            renderLoop(window);
+        }
+        cargador.detener();
         glfwTerminate();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
@@ -8,19 +8,20 @@
 #include <vector>
 #include <cmath>
 #include <stdexcept>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <omp.h>
 
-// ==================== Estructuras ====================
-struct Point {
-    double x, y, z;
-};
-
-struct Tetrahedron {
-    Point p1, p2, p3, p4;
-};
+#include "mallaComun.h"
 
 // ==================== Variables globales ====================
 GLuint VAO_points, VBO_points;
-GLuint VAO_lines, VBO_lines;
+GLuint VAO_lines, EBO_lines; // Aristas indexadas sobre VBO_points
 GLuint shaderProgramPoints, shaderProgramLines;
 
 float yaw = -90.0f, pitch = 0.0f;
@@ -142,8 +143,10 @@ void loadModel(const std::string& fileName, std::vector<Point>& points, std::vec
     std::cout << "Modelo cargado: " << nPoints << " puntos, " << nTets << " tetraedros.\n";
 }
 
-// Cargar datos en OpenGL
-void updateBuffers(const std::vector<Point>& points, const std::vector<Tetrahedron>& tets) {
+// Cargar datos en OpenGL (devuelve la cantidad de índices de aristas)
+size_t updateBuffers(std::vector<Point>& points, const std::vector<Tetrahedron>& tets) {
+    std::vector<GLuint> lineIndices = extraerAristasUnicas(indexarTetraedros(points, tets));
+
     std::vector<float> vertices;
     for (const auto& p : points) {
         vertices.push_back(p.x);
@@ -151,24 +154,6 @@ void updateBuffers(const std::vector<Point>& points, const std::vector<Tetrahedr
         vertices.push_back(p.z);
     }
 
-    std::vector<float> lineVertices;
-    for (const auto& t : tets) {
-        auto addEdge = [&](const Point& a, const Point& b) {
-            lineVertices.push_back(a.x);
-            lineVertices.push_back(a.y);
-            lineVertices.push_back(a.z);
-            lineVertices.push_back(b.x);
-            lineVertices.push_back(b.y);
-            lineVertices.push_back(b.z);
-        };
-        addEdge(t.p1, t.p2);
-        addEdge(t.p2, t.p3);
-        addEdge(t.p3, t.p1);
-        addEdge(t.p1, t.p4);
-        addEdge(t.p2, t.p4);
-        addEdge(t.p3, t.p4);
-    }
-
     // Buffers puntos
     glGenVertexArrays(1, &VAO_points);
     glGenBuffers(1, &VBO_points);
@@ -178,14 +163,19 @@ void updateBuffers(const std::vector<Point>& points, const std::vector<Tetrahedr
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    // Buffers líneas
+    // Buffers líneas: mismo VBO de puntos + índices únicos
     glGenVertexArrays(1, &VAO_lines);
-    glGenBuffers(1, &VBO_lines);
+    glGenBuffers(1, &EBO_lines);
     glBindVertexArray(VAO_lines);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_lines);
-    glBufferData(GL_ARRAY_BUFFER, lineVertices.size() * sizeof(float), lineVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, VBO_points);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO_lines);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, lineIndices.size() * sizeof(GLuint), lineIndices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    std::cout << "Aristas únicas: " << lineIndices.size() / 2 << " (antes " << tets.size() * 6 << ").\n";
+    return lineIndices.size();
 }
 
 // Render loop
@@ -221,7 +211,7 @@ void renderLoop(GLFWwindow* window, size_t pointCount, size_t lineCount) {
 
         glBindVertexArray(VAO_lines);
         glLineWidth(1.5f);
-        glDrawArrays(GL_LINES, 0, lineCount);
+        glDrawElements(GL_LINES, lineCount, GL_UNSIGNED_INT, (void*)0);
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -255,8 +245,8 @@ int main() {
         shaderProgramPoints = compileShader(vertexShaderSource, fragmentShaderSourcePoints);
         shaderProgramLines = compileShader(vertexShaderSource, fragmentShaderSourceLines);
 
-        updateBuffers(points, tets);
-        renderLoop(window, points.size(), tets.size() * 12);
+        size_t lineCount = updateBuffers(points, tets);
+        renderLoop(window, points.size(), lineCount);
 
         glfwTerminate();
     } catch (const std::exception& e) {
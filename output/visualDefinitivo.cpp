@@ -12,20 +12,19 @@
 #include <map>
 #include <random>
 
-// ==================== Estructuras ====================
-struct Point { double x, y, z; };
-struct Tetrahedron { Point p1, p2, p3, p4; };
+#include "mallaComun.h"
+#include "escenaComun.h"
 
+// ==================== Estructuras ====================
 struct ModelPart {
     GLuint VAO_points, VBO_points;
     GLuint VAO_lines, VBO_lines;
     size_t pointCount, lineCount;
     glm::vec3 color;
-    std::vector<Point> points; // <-- Añadido para normalización global
-};
-
-struct Range {
-    double minX, maxX, minY, maxY, minZ, maxZ;
+    std::vector<Point> points; // Tal como vienen en el .bin
+    Range rango;               // Rango original del órgano
+    glm::vec3 escala, desplazamiento; // Ver normalizarGlobal
+    glm::mat4 model;           // Afín [-1, 1] del órgano -> caja global
 };
 
 // ==================== Variables globales ====================
@@ -154,17 +153,8 @@ void loadModel(const std::string& fileName, ModelPart& part, const Range& r) {
     std::vector<Tetrahedron> tets(nTets);
     in.read(reinterpret_cast<char*>(tets.data()), nTets * sizeof(Tetrahedron));
 
-    // Desnormalizar
-    auto desnormalizar = [&](Point& p) {
-        p.x = ((p.x + 1) / 2.0) * (r.maxX - r.minX) + r.minX;
-        p.y = ((p.y + 1) / 2.0) * (r.maxY - r.minY) + r.minY;
-        p.z = ((p.z + 1) / 2.0) * (r.maxZ - r.minZ) + r.minZ;
-    };
-
-    for (auto& p : part.points) desnormalizar(p);
-    for (auto& t : tets) { desnormalizar(t.p1); desnormalizar(t.p2); desnormalizar(t.p3); desnormalizar(t.p4); }
-
-    // Buffers (temporal, se regenerará después de normalizar globalmente)
+    // Sin desnormalizar: la afín de la parte se aplica con `model`
+    part.rango = r;
     part.pointCount = nPoints;
     part.lineCount = nTets * 12; // 6 edges * 2 vertices
     static std::mt19937 gen{ std::random_device{}() };
@@ -172,27 +162,12 @@ void loadModel(const std::string& fileName, ModelPart& part, const Range& r) {
     part.color = glm::vec3(dist(gen), dist(gen), dist(gen));
 }
 
-void normalizarGlobal() {
-    // Calcular bounding box global
-    double gMinX = 1e9, gMaxX = -1e9;
-    double gMinY = 1e9, gMaxY = -1e9;
-    double gMinZ = 1e9, gMaxZ = -1e9;
-
+// La afín de cada parte (ver normalizarGlobal en escenaComun.h) va en su
+// matriz `model`; los vértices se suben tal como vienen en el .bin.
+void crearBuffersPartes() {
+    normalizarGlobal(modelParts);
     for (auto& part : modelParts) {
-        for (auto& p : part.points) {
-            gMinX = std::min(gMinX, p.x); gMaxX = std::max(gMaxX, p.x);
-            gMinY = std::min(gMinY, p.y); gMaxY = std::max(gMaxY, p.y);
-            gMinZ = std::min(gMinZ, p.z); gMaxZ = std::max(gMaxZ, p.z);
-        }
-    }
-
-    // Normalizar todos
-    for (auto& part : modelParts) {
-        for (auto& p : part.points) {
-            p.x = ((p.x - gMinX) / (gMaxX - gMinX)) * 2 - 1;
-            p.y = ((p.y - gMinY) / (gMaxY - gMinY)) * 2 - 1;
-            p.z = ((p.z - gMinZ) / (gMaxZ - gMinZ)) * 2 - 1;
-        }
+        part.model = glm::scale(glm::translate(glm::mat4(1.0f), part.desplazamiento), part.escala);
     }
 
     // Regenerar buffers
@@ -221,16 +196,16 @@ void renderLoop(GLFWwindow* window) {
         cameraPos.y = radius * sin(glm::radians(pitch));
         cameraPos.z = radius * sin(glm::radians(yaw)) * cos(glm::radians(pitch));
 
-        glm::mat4 model = glm::mat4(1.0f);
         glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), cameraUp);
         glm::mat4 proj = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 200.0f);
 
         glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
 
+        GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
         for (auto& part : modelParts) {
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(part.model));
             glUniform3fv(glGetUniformLocation(shaderProgram, "uColor"), 1, glm::value_ptr(part.color));
 
             glBindVertexArray(part.VAO_points);
@@ -360,7 +335,7 @@ int main() {
             }
         }
 
-        normalizarGlobal();
+        crearBuffersPartes();
         renderLoop(window);
         glfwTerminate();
     } catch (const std::exception& e) {
@@ -4,23 +4,30 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <tuple>
 #include <fstream>
 #include <vector>
 #include <string>
 #include <filesystem>
 #include <sstream>
-#include <map>
 #include <random>
+#include <omp.h>
 
-// ==================== Estructuras ====================
-struct Point { double x, y, z; };
-struct Tetrahedron { Point p1, p2, p3, p4; };
+#include "mallaComun.h"
 
+// ==================== Estructuras ====================
 struct ModelPart {
     GLuint VAO_points, VBO_points;
-    GLuint VAO_lines, VBO_lines;
+    GLuint VAO_lines, EBO_lines; // Aristas indexadas sobre VBO_points
     size_t pointCount, lineCount;
     glm::vec3 color;
+    glm::mat4 model; // Afín [-1, 1] -> rango original del órgano
 };
 
 struct Range {
@@ -155,24 +162,16 @@ void loadModel(const std::string& fileName, ModelPart& part) {
     std::vector<Tetrahedron> tets(nTets);
     in.read(reinterpret_cast<char*>(tets.data()), nTets * sizeof(Tetrahedron));
 
-    // Desnormalizar
+    std::vector<GLuint> lineIndices = extraerAristasUnicas(indexarTetraedros(points, tets));
+
+    // Desnormalizar en el shader: p * (max - min) / 2 + (max + min) / 2
     std::string baseName = std::filesystem::path(fileName).stem().string();
     if (rangos.find(baseName) == rangos.end()) throw std::runtime_error("No hay rangos para " + baseName);
     Range r = rangos[baseName];
 
-    auto desnormalizar = [&](Point& p) {
-        p.x = ((p.x + 1) / 2.0) * (r.maxX - r.minX) + r.minX;
-        p.y = ((p.y + 1) / 2.0) * (r.maxY - r.minY) + r.minY;
-        p.z = ((p.z + 1) / 2.0) * (r.maxZ - r.minZ) + r.minZ;
-    };
-
-    for (auto& p : points) desnormalizar(p);
-    for (auto& t : tets) {
-        desnormalizar(t.p1);
-        desnormalizar(t.p2);
-        desnormalizar(t.p3);
-        desnormalizar(t.p4);
-    }
+    glm::vec3 centro((r.maxX + r.minX) / 2.0, (r.maxY + r.minY) / 2.0, (r.maxZ + r.minZ) / 2.0);
+    glm::vec3 semiEje((r.maxX - r.minX) / 2.0, (r.maxY - r.minY) / 2.0, (r.maxZ - r.minZ) / 2.0);
+    part.model = glm::scale(glm::translate(glm::mat4(1.0f), centro), semiEje);
 
     // Buffers
     std::vector<float> pointData;
@@ -182,16 +181,6 @@ void loadModel(const std::string& fileName, ModelPart& part) {
         pointData.push_back(p.z);
     }
 
-    std::vector<float> lineData;
-    for (auto& t : tets) {
-        auto addEdge = [&](Point a, Point b) {
-            lineData.insert(lineData.end(), { (float)a.x,(float)a.y,(float)a.z,
-                                              (float)b.x,(float)b.y,(float)b.z });
-        };
-        addEdge(t.p1, t.p2); addEdge(t.p2, t.p3); addEdge(t.p3, t.p1);
-        addEdge(t.p1, t.p4); addEdge(t.p2, t.p4); addEdge(t.p3, t.p4);
-    }
-
     // Puntos
     glGenVertexArrays(1, &part.VAO_points);
     glGenBuffers(1, &part.VBO_points);
@@ -201,17 +190,19 @@ void loadModel(const std::string& fileName, ModelPart& part) {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    // Líneas
+    // Líneas: mismo VBO de puntos + índices únicos
     glGenVertexArrays(1, &part.VAO_lines);
-    glGenBuffers(1, &part.VBO_lines);
+    glGenBuffers(1, &part.EBO_lines);
     glBindVertexArray(part.VAO_lines);
-    glBindBuffer(GL_ARRAY_BUFFER, part.VBO_lines);
-    glBufferData(GL_ARRAY_BUFFER, lineData.size() * sizeof(float), lineData.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, part.VBO_points);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, part.EBO_lines);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, lineIndices.size() * sizeof(GLuint), lineIndices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
 
     part.pointCount = points.size();
-    part.lineCount = lineData.size() / 3;
+    part.lineCount = lineIndices.size();
 
     // Color aleatorio
     static std::mt19937 gen{ std::random_device{}() };
@@ -228,16 +219,16 @@ void renderLoop(GLFWwindow* window) {
         cameraPos.y = radius * sin(glm::radians(pitch));
         cameraPos.z = radius * sin(glm::radians(yaw)) * cos(glm::radians(pitch));
 
-        glm::mat4 model = glm::mat4(1.0f);
         glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), cameraUp);
         glm::mat4 proj = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 200.0f);
 
         glUseProgram(shaderProgram);
-        glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
 
+        GLint modelLoc = glGetUniformLocation(shaderProgram, "model");
         for (auto& part : modelParts) {
+            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(part.model));
             glUniform3fv(glGetUniformLocation(shaderProgram, "uColor"), 1, glm::value_ptr(part.color));
 
             glBindVertexArray(part.VAO_points);
@@ -246,7 +237,7 @@ void renderLoop(GLFWwindow* window) {
 
             glBindVertexArray(part.VAO_lines);
             glLineWidth(1.2f);
-            glDrawArrays(GL_LINES, 0, part.lineCount);
+            glDrawElements(GL_LINES, part.lineCount, GL_UNSIGNED_INT, (void*)0);
         }
 
         glfwSwapBuffers(window);
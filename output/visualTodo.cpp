@@ -4,21 +4,42 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <numeric>
+#include <tuple>
 #include <fstream>
 #include <vector>
 #include <string>
 #include <filesystem>
 #include <random>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <omp.h>
 
-// ==================== Estructuras ====================
-struct Point { double x, y, z; };
-struct Tetrahedron { Point p1, p2, p3, p4; };
+#include "mallaComun.h"
+#include "escenaComun.h"
 
+// ==================== Estructuras ====================
 struct ModelPart {
-    GLuint VAO_points, VBO_points;
-    GLuint VAO_lines, VBO_lines;
-    size_t pointCount, lineCount;
+    std::string nombre;
+    size_t firstPoint, pointCount;   // Rango en VBO_scene
+    size_t firstLine, lineCount;     // Rango en EBO_scene
     glm::vec3 color;
+    bool visible = true;
+    std::vector<Point> points;
+    std::vector<GLuint> lineIndices; // Índices locales a `points`
+    AABB caja;
+    std::vector<Bloque> bloques;
+    bool cargada = false;            // Ya está en los buffers de escena
 };
 
 // ==================== Variables globales ====================
@@ -34,24 +55,39 @@ float fov = 45.0f;
 glm::vec3 cameraPos;
 glm::vec3 cameraUp(0.0f, 1.0f, 0.0f);
 
+// ==================== Buffers de escena ====================
+// Ver escenaComun.h.
+GLuint VAO_scene, UBO_colores;
+BuffersEscena escena;
+RangosDibujo dibujo;
+int parteSeleccionada = -1;       // -1: ninguna
+
 // ==================== Shaders ====================
+// Todas las partes comparten un VBO; aPart indexa el bloque de colores.
+// El tamaño del arreglo debe coincidir con MAX_PARTES.
 const char* vertexShaderSource = R"(
 #version 330 core
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in uint aPart;
+layout (std140) uniform Colores {
+    vec4 colores[256];
+};
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+flat out vec3 vColor;
 void main() {
+    vColor = colores[aPart].rgb;
     gl_Position = projection * view * model * vec4(aPos, 1.0);
 }
 )";
 
 const char* fragmentShaderSource = R"(
 #version 330 core
+flat in vec3 vColor;
 out vec4 FragColor;
-uniform vec3 uColor;
 void main() {
-    FragColor = vec4(uColor, 1.0);
+    FragColor = vec4(vColor, 1.0);
 }
 )";
 
@@ -102,66 +138,103 @@ GLuint compileShader(const char* vs, const char* fs) {
     return program;
 }
 
+// Se llama desde los hilos del cargador: sólo toca los campos de `part`
+// que el hilo de GL no lee hasta que la parte está cargada.
 void loadModel(const std::string& fileName, ModelPart& part) {
-    std::ifstream in(fileName, std::ios::binary);
-    if (!in) throw std::runtime_error("No se pudo abrir: " + fileName);
-
-    size_t nPoints, nTets;
-    in.read(reinterpret_cast<char*>(&nPoints), sizeof(size_t));
-    std::vector<Point> points(nPoints);
-    in.read(reinterpret_cast<char*>(points.data()), nPoints * sizeof(Point));
-
-    in.read(reinterpret_cast<char*>(&nTets), sizeof(size_t));
-    std::vector<Tetrahedron> tets(nTets);
-    in.read(reinterpret_cast<char*>(tets.data()), nTets * sizeof(Tetrahedron));
-
-    // Buffers
-    std::vector<float> pointData;
-    for (auto& p : points) {
-        pointData.push_back(p.x);
-        pointData.push_back(p.y);
-        pointData.push_back(p.z);
-    }
+    std::vector<Tetrahedron> tets;
+    leerBin(fileName, part.points, tets);
+
+    part.lineIndices = extraerAristasUnicas(indexarTetraedros(part.points, tets));
 
-    std::vector<float> lineData;
-    for (auto& t : tets) {
-        auto addEdge = [&](Point a, Point b) {
-            lineData.insert(lineData.end(), { (float)a.x,(float)a.y,(float)a.z,
-                                              (float)b.x,(float)b.y,(float)b.z });
-        };
-        addEdge(t.p1, t.p2); addEdge(t.p2, t.p3); addEdge(t.p3, t.p1);
-        addEdge(t.p1, t.p4); addEdge(t.p2, t.p4); addEdge(t.p3, t.p4);
+    part.pointCount = part.points.size();
+    part.lineCount = part.lineIndices.size();
+}
+
+// ==================== Frustum culling ====================
+// Ver escenaComun.h. Las partes ya están en la caja global, así que la afín
+// es la identidad.
+ConteoDibujo estadisticas;
+
+// ==================== Buffers de escena ====================
+// Arma los rangos de dibujo con las partes visibles y los bloques que tocan
+// el frustum (los rangos contiguos se fusionan); no sube nada a la GPU.
+void actualizarRangosDibujo() {
+    dibujo.limpiar();
+    estadisticas = {};
+    const glm::vec3 identidad(1.0f), origen(0.0f);
+
+    for (const auto& part : modelParts) {
+        if (!part.visible || !part.cargada) continue;
+        agregarBloquesVisibles(part.bloques, part.firstPoint, part.firstLine, cajaVisible(part.caja, identidad, origen),
+                               [&](const AABB& c) { return cajaVisible(c, identidad, origen); }, dibujo, estadisticas);
     }
+}
 
-    // Puntos
-    glGenVertexArrays(1, &part.VAO_points);
-    glGenBuffers(1, &part.VBO_points);
-    glBindVertexArray(part.VAO_points);
-    glBindBuffer(GL_ARRAY_BUFFER, part.VBO_points);
-    glBufferData(GL_ARRAY_BUFFER, pointData.size() * sizeof(float), pointData.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+// Los buffers de escena arrancan vacíos y crecen a medida que llegan las
+// partes (ver "Carga en paralelo"); los colores ya se conocen.
+void crearBuffersEscena() {
+    crearEscena(modelParts.size(), shaderProgram, "Colores", MAX_PARTES * sizeof(glm::vec4), VAO_scene, UBO_colores);
+
+    std::vector<glm::vec4> colores(MAX_PARTES, glm::vec4(0.0f));
+    for (size_t i = 0; i < modelParts.size(); ++i) colores[i] = glm::vec4(modelParts[i].color, 1.0f);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, colores.size() * sizeof(glm::vec4), colores.data());
+}
 
-    // Líneas
-    glGenVertexArrays(1, &part.VAO_lines);
-    glGenBuffers(1, &part.VBO_lines);
-    glBindVertexArray(part.VAO_lines);
-    glBindBuffer(GL_ARRAY_BUFFER, part.VBO_lines);
-    glBufferData(GL_ARRAY_BUFFER, lineData.size() * sizeof(float), lineData.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+// ==================== Carga en paralelo ====================
+// Ver escenaComun.h; cada parte se lee, indexa, reordena (construirBloques)
+// y empaqueta en los hilos del cargador.
+
+// Corre en los hilos del cargador
+void decodificarParte(size_t i, const std::string& ruta, ParteLista& lista) {
+    ModelPart& part = modelParts[i];
+    loadModel(ruta, part);
+    construirBloques(part.points, part.lineIndices, {}, part.caja, part.bloques);
+    lista.vertices = empaquetarPuntos(part.points, i);
+    lista.indices = part.lineIndices;
+}
+
+void descartarParte(size_t i) {
+    ModelPart& part = modelParts[i];
+    part.points.clear(); part.lineIndices.clear(); part.bloques.clear();
+    part.pointCount = part.lineCount = 0;
+}
+
+CargadorPartes cargador;
+
+void enlazarBuffersEscena() {
+    glBindVertexArray(VAO_scene);
+    glBindBuffer(GL_ARRAY_BUFFER, escena.vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertice), (void*)0);
     glEnableVertexAttribArray(0);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(Vertice), (void*)offsetof(Vertice, parte));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, escena.ebo);
+    glBindVertexArray(0);
+}
 
-    part.pointCount = points.size();
-    part.lineCount = lineData.size() / 3;
+// Devuelve cuántas partes subió
+size_t subirPartes(size_t maxBytes) {
+    return subirPartesListas(cargador, escena, sizeof(Vertice), maxBytes,
+        [](size_t i, size_t firstPoint, size_t firstLine) {
+            ModelPart& part = modelParts[i];
+            part.firstPoint = firstPoint;
+            part.firstLine = firstLine;
+            part.cargada = true;
+        }, enlazarBuffersEscena);
+}
 
-    // Color aleatorio
-    static std::mt19937 gen{ std::random_device{}() };
-    std::uniform_real_distribution<float> dist(0.2f, 1.0f);
-    part.color = glm::vec3(dist(gen), dist(gen), dist(gen));
+// Flechas: elegir parte, espacio: mostrar/ocultar, 0: mostrar todas.
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
+    if (action == GLFW_PRESS) teclaPartes(key, modelParts, parteSeleccionada);
 }
 
 void renderLoop(GLFWwindow* window) {
+    int cuadro = 0;
     while (!glfwWindowShouldClose(window)) {
+        // Lo que terminaron los hilos del cargador entra antes de dibujar
+        if (subirPartes(MAX_BYTES_SUBIDA) > 0 && !cargador.pendientes())
+            std::cout << "Carga completa: " << cargador.msCarga() << " ms\n";
+
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -173,21 +246,25 @@ void renderLoop(GLFWwindow* window) {
         glm::mat4 view = glm::lookAt(cameraPos, glm::vec3(0.0f), cameraUp);
         glm::mat4 proj = glm::perspective(glm::radians(fov), 800.0f / 600.0f, 0.1f, 200.0f);
 
+        extraerPlanosFrustum(proj * view * model);
+        actualizarRangosDibujo();
+
         glUseProgram(shaderProgram);
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "model"), 1, GL_FALSE, glm::value_ptr(model));
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "view"), 1, GL_FALSE, glm::value_ptr(view));
         glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "projection"), 1, GL_FALSE, glm::value_ptr(proj));
 
-        for (auto& part : modelParts) {
-            glUniform3fv(glGetUniformLocation(shaderProgram, "uColor"), 1, glm::value_ptr(part.color));
-
-            glBindVertexArray(part.VAO_points);
-            glPointSize(3.0f);
-            glDrawArrays(GL_POINTS, 0, part.pointCount);
-
-            glBindVertexArray(part.VAO_lines);
-            glLineWidth(1.2f);
-            glDrawArrays(GL_LINES, 0, part.lineCount);
+        // Una sola llamada por primitiva para todas las partes visibles
+        glBindVertexArray(VAO_scene);
+        glMultiDrawArrays(GL_POINTS, dibujo.pointFirsts.data(), dibujo.pointCounts.data(), dibujo.pointFirsts.size());
+        glMultiDrawElementsBaseVertex(GL_LINES, dibujo.lineCounts.data(), GL_UNSIGNED_INT, dibujo.lineOffsets.data(),
+                                      dibujo.lineCounts.size(), dibujo.lineBaseVertex.data());
+
+        if (++cuadro % 30 == 0) {
+            std::ostringstream titulo;
+            titulo << "Puntos " << estadisticas.puntosDibujados << " (descartados " << estadisticas.puntosDescartados
+                   << ") | Aristas " << estadisticas.aristasDibujadas << " (descartadas " << estadisticas.aristasDescartadas << ")";
+            glfwSetWindowTitle(window, titulo.str().c_str());
         }
 
         glfwSwapBuffers(window);
@@ -207,24 +284,34 @@ int main() {
 
         glfwSetCursorPosCallback(window, mouse_callback);
         glfwSetScrollCallback(window, scroll_callback);
+        glfwSetKeyCallback(window, key_callback);
         glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
         gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
         glEnable(GL_DEPTH_TEST);
+        glPointSize(3.0f);
+        glLineWidth(1.2f);
 
         shaderProgram = compileShader(vertexShaderSource, fragmentShaderSource);
 
-        // Leer todos los bin
+        // Registrar todos los bin con un color aleatorio; la geometría llega después
+        std::vector<std::string> rutasBin;
+        std::mt19937 gen{ std::random_device{}() };
+        std::uniform_real_distribution<float> dist(0.2f, 1.0f);
         for (auto& entry : std::filesystem::directory_iterator("output")) {
             if (entry.path().extension() == ".bin") {
                 ModelPart part;
-                loadModel(entry.path().string(), part);
+                part.nombre = entry.path().stem().string();
+                part.color = glm::vec3(dist(gen), dist(gen), dist(gen));
                 modelParts.push_back(part);
-                std::cout << "Cargado: " << entry.path() << "\n";
+                rutasBin.push_back(entry.path().string());
             }
         }
 
+        crearBuffersEscena();
+        cargador.iniciar(rutasBin, decodificarParte, descartarParte);
         renderLoop(window);
+        cargador.detener();
         glfwTerminate();
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << "\n";
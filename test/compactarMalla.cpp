@@ -0,0 +1,208 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <tuple>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <omp.h>
+
+#include "../output/mallaComun.h"
+
+// ------------------------- PARÁMETROS -------------------------
+// Formato .qbin (little endian):
+//   MAGIA_COMPACTO, nPuntos (uint32), nAristas (uint32), caja min[3] y max[3] (float),
+//   nPuntos * 3 uint16 relativos a la caja (0 = min, 65535 = max),
+//   bytesAristas (uint64) y el flujo de aristas,
+//   y un bloque de borde: MAGIA_BORDE, nAristasBorde (uint32), bytes (uint64) y
+//   el flujo de las aristas de las caras de borde (las que están en un solo
+//   tetraedro), que el visor usa como representación reducida.
+// Las aristas van sin repetir, como (a < b) ordenadas por a y después por b;
+// cada una se guarda como dos varint LEB128: a - aAnterior y b - a. Los
+// puntos se reordenan por código Morton para que esas diferencias sean
+// chicas y casi siempre quepan en un byte. Las magias y la codificación de
+// las aristas están en mallaComun.h, que también usa el visor.
+const double MAX_CUANTIZADO = 65535.0;
+
+// ------------------------- ARISTAS -------------------------
+// indexarTetraedros viene de mallaComun.h; acá las aristas se guardan como
+// pares y sin las degeneradas.
+std::vector<std::pair<uint32_t, uint32_t>> aristasUnicas(const std::vector<uint32_t>& tetIndices) {
+    static const int aristas[6][2] = {{0,1},{1,2},{2,0},{0,3},{1,3},{2,3}};
+    std::vector<std::pair<uint32_t, uint32_t>> r;
+    r.reserve(tetIndices.size() / 4 * 6);
+    for (size_t i = 0; i + 3 < tetIndices.size(); i += 4) {
+        for (int e = 0; e < 6; ++e) {
+            uint32_t a = tetIndices[i + aristas[e][0]], b = tetIndices[i + aristas[e][1]];
+            if (a != b) r.push_back({std::min(a, b), std::max(a, b)});
+        }
+    }
+    std::sort(r.begin(), r.end());
+    r.erase(std::unique(r.begin(), r.end()), r.end());
+    return r;
+}
+
+// Aristas de las caras que aparecen en un solo tetraedro
+std::vector<std::pair<uint32_t, uint32_t>> aristasBorde(const std::vector<uint32_t>& tetIndices) {
+    std::vector<std::array<uint32_t, 3>> caras;
+    caras.reserve(tetIndices.size());
+    for (size_t i = 0; i + 3 < tetIndices.size(); i += 4) {
+        for (int k = 0; k < 4; ++k) {
+            std::array<uint32_t, 3> c;
+            for (int j = 0, m = 0; j < 4; ++j) if (j != k) c[m++] = tetIndices[i + j];
+            std::sort(c.begin(), c.end());
+            caras.push_back(c);
+        }
+    }
+    std::sort(caras.begin(), caras.end());
+
+    std::vector<std::pair<uint32_t, uint32_t>> r;
+    for (size_t i = 0; i < caras.size(); ) {
+        size_t j = i + 1;
+        while (j < caras.size() && caras[j] == caras[i]) ++j;
+        if (j - i == 1) {
+            const auto& c = caras[i];
+            if (c[0] != c[1]) r.push_back({c[0], c[1]});
+            if (c[0] != c[2]) r.push_back({c[0], c[2]});
+            if (c[1] != c[2]) r.push_back({c[1], c[2]});
+        }
+        i = j;
+    }
+    std::sort(r.begin(), r.end());
+    r.erase(std::unique(r.begin(), r.end()), r.end());
+    return r;
+}
+
+// ------------------------- CUANTIZADO -------------------------
+// Orden Morton (10 bits por eje) sobre los puntos ya cuantizados; reasigna
+// las aristas y las de borde
+void ordenarMorton(std::vector<uint16_t>& q, std::vector<std::pair<uint32_t, uint32_t>>& aristas,
+                   std::vector<std::pair<uint32_t, uint32_t>>& borde) {
+    size_t n = q.size() / 3;
+    std::vector<std::pair<uint32_t, uint32_t>> codigos(n);
+    for (size_t i = 0; i < n; ++i) {
+        codigos[i] = {(expandirBits(q[i * 3] >> 6) << 2) | (expandirBits(q[i * 3 + 1] >> 6) << 1) |
+                      expandirBits(q[i * 3 + 2] >> 6), (uint32_t)i};
+    }
+    std::sort(codigos.begin(), codigos.end());
+
+    std::vector<uint16_t> ordenados(q.size());
+    std::vector<uint32_t> nuevoIndice(n);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy_n(&q[codigos[i].second * 3], 3, &ordenados[i * 3]);
+        nuevoIndice[codigos[i].second] = i;
+    }
+    q.swap(ordenados);
+
+    for (auto* lista : {&aristas, &borde}) {
+        for (auto& [a, b] : *lista) {
+            uint32_t na = nuevoIndice[a], nb = nuevoIndice[b];
+            a = std::min(na, nb);
+            b = std::max(na, nb);
+        }
+        std::sort(lista->begin(), lista->end());
+    }
+}
+
+
+// ------------------------- MAIN -------------------------
+// Uso: compactarMalla [carpeta]  (por defecto "output")
+// Genera <nombre>.qbin junto a cada <nombre>.bin; el visor lo prefiere
+// al .bin mientras no sea más viejo que él.
+int main(int argc, char** argv) {
+    std::string carpeta = argc > 1 ? argv[1] : "output";
+
+    std::vector<std::string> rutas;
+    for (auto& entry : std::filesystem::directory_iterator(carpeta)) {
+        if (entry.path().extension() == ".bin") rutas.push_back(entry.path().string());
+    }
+    std::sort(rutas.begin(), rutas.end());
+
+    uintmax_t totalBin = 0, totalQbin = 0;
+
+    #pragma omp parallel for schedule(dynamic) reduction(+:totalBin, totalQbin)
+    for (size_t i = 0; i < rutas.size(); ++i) {
+        try {
+            std::vector<Point> points;
+            std::vector<Tetrahedron> tets;
+            leerBin(rutas[i], points, tets);
+            std::vector<uint32_t> indices = indexarTetraedros(points, tets);
+            auto aristas = aristasUnicas(indices);
+            auto borde = aristasBorde(indices);
+            indices.clear();
+            indices.shrink_to_fit();
+            tets.clear();
+            tets.shrink_to_fit();
+            if (points.size() > UINT32_MAX) throw std::runtime_error("Demasiados puntos: " + rutas[i]);
+
+            float mn[3] = {1e30f, 1e30f, 1e30f}, mx[3] = {-1e30f, -1e30f, -1e30f};
+            for (const auto& p : points) {
+                const double c[3] = {p.x, p.y, p.z};
+                for (int k = 0; k < 3; ++k) {
+                    mn[k] = std::min(mn[k], (float)c[k]);
+                    mx[k] = std::max(mx[k], (float)c[k]);
+                }
+            }
+
+            // Cuantizado y error máximo relativo al lado de la caja
+            std::vector<uint16_t> q(points.size() * 3);
+            double errorMax = 0.0;
+            for (size_t j = 0; j < points.size(); ++j) {
+                const double c[3] = {points[j].x, points[j].y, points[j].z};
+                for (int k = 0; k < 3; ++k) {
+                    double ext = std::max((double)mx[k] - mn[k], 1e-12);
+                    double t = std::min(std::max((c[k] - mn[k]) / ext, 0.0), 1.0);
+                    q[j * 3 + k] = (uint16_t)std::lround(t * MAX_CUANTIZADO);
+                    errorMax = std::max(errorMax, std::abs(q[j * 3 + k] / MAX_CUANTIZADO - t));
+                }
+            }
+            ordenarMorton(q, aristas, borde);
+            std::vector<uint8_t> flujo = codificarAristas(aristas);
+            std::vector<uint8_t> flujoBorde = codificarAristas(borde);
+
+            std::string rutaQbin = std::filesystem::path(rutas[i]).replace_extension(".qbin").string();
+            std::ofstream out(rutaQbin, std::ios::binary);
+            if (!out) throw std::runtime_error("No se pudo escribir: " + rutaQbin);
+            uint32_t nPuntos = points.size(), nAristas = aristas.size();
+            uint64_t bytesAristas = flujo.size();
+            out.write(MAGIA_COMPACTO, sizeof(MAGIA_COMPACTO));
+            out.write(reinterpret_cast<const char*>(&nPuntos), sizeof(uint32_t));
+            out.write(reinterpret_cast<const char*>(&nAristas), sizeof(uint32_t));
+            out.write(reinterpret_cast<const char*>(mn), sizeof(mn));
+            out.write(reinterpret_cast<const char*>(mx), sizeof(mx));
+            out.write(reinterpret_cast<const char*>(q.data()), q.size() * sizeof(uint16_t));
+            out.write(reinterpret_cast<const char*>(&bytesAristas), sizeof(uint64_t));
+            out.write(reinterpret_cast<const char*>(flujo.data()), flujo.size());
+            uint32_t nBorde = borde.size();
+            uint64_t bytesBorde = flujoBorde.size();
+            out.write(MAGIA_BORDE, sizeof(MAGIA_BORDE));
+            out.write(reinterpret_cast<const char*>(&nBorde), sizeof(uint32_t));
+            out.write(reinterpret_cast<const char*>(&bytesBorde), sizeof(uint64_t));
+            out.write(reinterpret_cast<const char*>(flujoBorde.data()), flujoBorde.size());
+            out.close();
+
+            uintmax_t bytesBin = std::filesystem::file_size(rutas[i]);
+            uintmax_t bytesQbin = std::filesystem::file_size(rutaQbin);
+            totalBin += bytesBin;
+            totalQbin += bytesQbin;
+
+            #pragma omp critical
+            std::cout << "Compactado: " << rutaQbin << " (" << nPuntos << " puntos, " << nAristas << " aristas, "
+                      << bytesBin / 1024 << " KB -> " << bytesQbin / 1024 << " KB, error máx "
+                      << errorMax << " del lado de la caja)\n";
+        } catch (const std::exception& e) {
+            #pragma omp critical
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+
+    if (totalQbin > 0)
+        std::cout << "Total: " << totalBin / 1024 << " KB -> " << totalQbin / 1024 << " KB ("
+                  << (double)totalBin / totalQbin << "x)\n";
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <omp.h>
+
+#include "../output/octreeComun.h"
+
+// ------------------------- ESTRUCTURAS BÁSICAS -------------------------
+struct Point { double x, y, z; };
+
+// ------------------------- PARÁMETROS -------------------------
+// NodoOctree, RESOLUCION_NODO y MAX_PUNTOS_NODO vienen de octreeComun.h,
+// que también incluye el visor.
+const uint32_t PROFUNDIDAD_MAX = 16;
+
+// ------------------------- LECTURA -------------------------
+std::vector<Point> leerPuntosBin(const std::string& ruta) {
+    std::ifstream in(ruta, std::ios::binary);
+    if (!in) throw std::runtime_error("No se pudo abrir: " + ruta);
+
+    size_t nPoints;
+    in.read(reinterpret_cast<char*>(&nPoints), sizeof(size_t));
+    std::vector<Point> points(nPoints);
+    in.read(reinterpret_cast<char*>(points.data()), nPoints * sizeof(Point));
+    if (!in) throw std::runtime_error("Archivo truncado: " + ruta);
+    return points;
+}
+
+// ------------------------- CONSTRUCCIÓN -------------------------
+// Cada nodo se queda con un punto por celda de una grilla
+// RESOLUCION_NODO^3 sobre su cubo; el resto baja al octante que le toca.
+int construirNodo(std::vector<Point>& pts, const double centro[3], double mitad, uint32_t nivel,
+                  std::vector<NodoOctree>& nodos, std::vector<std::vector<float>>& bloques) {
+    int idx = nodos.size();
+    NodoOctree nodo{};
+    for (int k = 0; k < 3; ++k) nodo.centro[k] = (float)centro[k];
+    nodo.mitad = (float)mitad;
+    nodo.nivel = nivel;
+    std::fill(std::begin(nodo.hijos), std::end(nodo.hijos), -1);
+    nodos.push_back(nodo);
+    bloques.emplace_back();
+
+    std::vector<float> muestra;
+    std::vector<Point> resto;
+    std::vector<Point> siguienteTrozo;
+
+    if (pts.size() <= MAX_PUNTOS_NODO || nivel == PROFUNDIDAD_MAX) {
+        // En la profundidad máxima el cubo ya no se parte (puntos repetidos
+        // o casi): lo que no entra en el slot sigue en otro nodo con el
+        // mismo cubo y nivel, colgado de hijos[0], así no se pierde ninguno.
+        if (pts.size() > MAX_PUNTOS_NODO) {
+            siguienteTrozo.assign(pts.begin() + MAX_PUNTOS_NODO, pts.end());
+            pts.resize(MAX_PUNTOS_NODO);
+        }
+        for (const auto& p : pts) muestra.insert(muestra.end(), {(float)p.x, (float)p.y, (float)p.z});
+    } else {
+        const int R = RESOLUCION_NODO;
+        std::vector<char> ocupada(R * R * R, 0);
+        auto celda = [&](double v, int k) {
+            int c = (int)std::floor((v - (centro[k] - mitad)) / (2.0 * mitad) * R);
+            return std::min(std::max(c, 0), R - 1);
+        };
+        for (const auto& p : pts) {
+            int id = (celda(p.x, 0) * R + celda(p.y, 1)) * R + celda(p.z, 2);
+            if (!ocupada[id]) {
+                ocupada[id] = 1;
+                muestra.insert(muestra.end(), {(float)p.x, (float)p.y, (float)p.z});
+            } else {
+                resto.push_back(p);
+            }
+        }
+    }
+    nodos[idx].nPuntos = muestra.size() / 3;
+    bloques[idx] = std::move(muestra);
+    pts.clear();
+    pts.shrink_to_fit();
+
+    if (!siguienteTrozo.empty()) {
+        int trozo = construirNodo(siguienteTrozo, centro, mitad, nivel, nodos, bloques);
+        nodos[idx].hijos[0] = trozo;
+        return idx;
+    }
+    if (resto.empty()) return idx;
+
+    std::vector<Point> octantes[8];
+    for (const auto& p : resto) {
+        int o = (p.x >= centro[0] ? 4 : 0) | (p.y >= centro[1] ? 2 : 0) | (p.z >= centro[2] ? 1 : 0);
+        octantes[o].push_back(p);
+    }
+    resto.clear();
+    resto.shrink_to_fit();
+
+    double m = mitad / 2.0;
+    for (int o = 0; o < 8; ++o) {
+        if (octantes[o].empty()) continue;
+        double c[3] = {centro[0] + ((o & 4) ? m : -m),
+                       centro[1] + ((o & 2) ? m : -m),
+                       centro[2] + ((o & 1) ? m : -m)};
+        int hijo = construirNodo(octantes[o], c, m, nivel + 1, nodos, bloques);
+        nodos[idx].hijos[o] = hijo;
+    }
+    return idx;
+}
+
+// Formato: magia, nNodos (uint32), tabla de nodos y luego los bloques de
+// puntos (float x, y, z) en el orden de la tabla. Los puntos quedan en las
+// coordenadas del .bin; el visor aplica la afín de la parte.
+void escribirOctree(const std::string& ruta, std::vector<NodoOctree>& nodos,
+                    const std::vector<std::vector<float>>& bloques) {
+    uint32_t nNodos = nodos.size();
+    uint64_t offset = sizeof(MAGIA_OCTREE) + sizeof(uint32_t) + nNodos * sizeof(NodoOctree);
+    for (uint32_t i = 0; i < nNodos; ++i) {
+        nodos[i].offset = offset;
+        offset += bloques[i].size() * sizeof(float);
+    }
+
+    std::ofstream out(ruta, std::ios::binary);
+    if (!out) throw std::runtime_error("No se pudo escribir: " + ruta);
+    out.write(MAGIA_OCTREE, sizeof(MAGIA_OCTREE));
+    out.write(reinterpret_cast<const char*>(&nNodos), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(nodos.data()), nNodos * sizeof(NodoOctree));
+    for (const auto& b : bloques)
+        out.write(reinterpret_cast<const char*>(b.data()), b.size() * sizeof(float));
+}
+
+// ------------------------- MAIN -------------------------
+// Uso: construirOctree [carpeta]  (por defecto "output")
+// Genera <nombre>.octree junto a cada <nombre>.bin.
+int main(int argc, char** argv) {
+    std::string carpeta = argc > 1 ? argv[1] : "output";
+
+    std::vector<std::string> rutas;
+    for (auto& entry : std::filesystem::directory_iterator(carpeta)) {
+        if (entry.path().extension() == ".bin") rutas.push_back(entry.path().string());
+    }
+    std::sort(rutas.begin(), rutas.end());
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < rutas.size(); ++i) {
+        try {
+            std::vector<Point> pts = leerPuntosBin(rutas[i]);
+            size_t total = pts.size();
+
+            std::vector<NodoOctree> nodos;
+            std::vector<std::vector<float>> bloques;
+            const double centro[3] = {0.0, 0.0, 0.0};
+            // Los .bin están normalizados a [-1, 1]; el margen cubre redondeos
+            construirNodo(pts, centro, 1.0 + 1e-6, 0, nodos, bloques);
+
+            std::string rutaOctree = std::filesystem::path(rutas[i]).replace_extension(".octree").string();
+            escribirOctree(rutaOctree, nodos, bloques);
+
+            #pragma omp critical
+            std::cout << "Octree: " << rutaOctree << " (" << total << " puntos, " << nodos.size() << " nodos)\n";
+        } catch (const std::exception& e) {
+            #pragma omp critical
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+    return 0;
+}
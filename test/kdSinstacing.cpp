@@ -8,128 +8,116 @@
 #include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <tuple>
 #include <limits>
 #include <cmath>
 #include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <deque>
+#include <atomic>
+#include <chrono>
+#include <thread>
 #include <unordered_map>
 #include <omp.h>
 #include <opencv2/opencv.hpp>
 
-// ------------------------- ESTRUCTURAS BÁSICAS -------------------------
-struct Point {
-    double x, y, z;
-    bool operator<(const Point& other) const {
-        return std::tie(x, y, z) < std::tie(other.x, other.y, other.z);
-    }
-    bool operator==(const Point& other) const {
-        return std::abs(x - other.x) < 1e-6 && 
-               std::abs(y - other.y) < 1e-6 && 
-               std::abs(z - other.z) < 1e-6;
-    }
-};
-
-struct Tetrahedron {
-    Point p1, p2, p3, p4;
-    
-    bool operator==(const Tetrahedron& other) const {
-        std::vector<Point> this_points = {p1, p2, p3, p4};
-        std::vector<Point> other_points = {other.p1, other.p2, other.p3, other.p4};
-        std::sort(this_points.begin(), this_points.end());
-        std::sort(other_points.begin(), other_points.end());
-        return this_points == other_points;
-    }
-};
-
-// ------------------------- KD-TREE OPTIMIZADO -------------------------
-class KDTree {
-private:
-    struct KDNode {
-        Point point;
-        int left = -1;
-        int right = -1;
-        int axis;
-    };
-
-    std::vector<KDNode> nodes;
-    int rootIndex = -1;
-    const double eps = 1e-6;
-
-    int buildTree(std::vector<Point>& points, int depth = 0) {
-        if (points.empty()) return -1;
-        
-        int axis = depth % 3;
-        auto mid = points.begin() + points.size()/2;
-        
-        std::nth_element(points.begin(), mid, points.end(),
-            [axis](const Point& a, const Point& b) {
-                return axis == 0 ? a.x < b.x : (axis == 1 ? a.y < b.y : a.z < b.z);
-            });
-        
-        int index = nodes.size();
-        nodes.push_back({*mid, -1, -1, axis});
-        
-        std::vector<Point> leftPoints(points.begin(), mid);
-        std::vector<Point> rightPoints(mid + 1, points.end());
-        
-        nodes[index].left = buildTree(leftPoints, depth + 1);
-        nodes[index].right = buildTree(rightPoints, depth + 1);
-        
-        return index;
-    }
-
-    void nearestNeighbor(int nodeIdx, const Point& target, 
-                        Point& best, double& bestDist, int depth = 0) const {
-        if (nodeIdx == -1) return;
-
-        const auto& node = nodes[nodeIdx];
-        double dist = std::sqrt(
-            (target.x - node.point.x) * (target.x - node.point.x) +
-            (target.y - node.point.y) * (target.y - node.point.y) +
-            (target.z - node.point.z) * (target.z - node.point.z)
-        );
-
-        if (dist < bestDist) {
-            bestDist = dist;
-            best = node.point;
-        }
+#include "../output/mallaComun.h"
+#include "../output/localizador.h"
 
-        double diff;
-        if (node.axis == 0) diff = target.x - node.point.x;
-        else if (node.axis == 1) diff = target.y - node.point.y;
-        else diff = target.z - node.point.z;
+// ------------------------- ESTRUCTURAS BÁSICAS -------------------------
+// Point y Tetrahedron vienen de mallaComun.h; acá sólo se agregan las
+// comparaciones que usa la triangulación.
+bool operator<(const Point& a, const Point& b) {
+    return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+}
+bool operator==(const Point& a, const Point& b) {
+    return std::abs(a.x - b.x) < 1e-6 && 
+           std::abs(a.y - b.y) < 1e-6 && 
+           std::abs(a.z - b.z) < 1e-6;
+}
 
-        int near = diff <= 0 ? node.left : node.right;
-        int far = diff <= 0 ? node.right : node.left;
+bool operator==(const Tetrahedron& a, const Tetrahedron& b) {
+    std::vector<Point> this_points = {a.p1, a.p2, a.p3, a.p4};
+    std::vector<Point> other_points = {b.p1, b.p2, b.p3, b.p4};
+    std::sort(this_points.begin(), this_points.end());
+    std::sort(other_points.begin(), other_points.end());
+    return this_points == other_points;
+}
 
-        nearestNeighbor(near, target, best, bestDist, depth + 1);
+// ------------------------- MEMORIA DE TRABAJO -------------------------
+// Cada hilo cuenta las asignaciones que hace con el operator new global; así
+// se puede comprobar que el bucle de inserción de Delaunay no toca el heap
+// una vez que la memoria de trabajo alcanzó su tamaño.
+thread_local size_t asignacionesHeap = 0;
 
-        if (diff * diff < bestDist) {
-            nearestNeighbor(far, target, best, bestDist, depth + 1);
+void* operator new(std::size_t n) {
+    ++asignacionesHeap;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+// Arena de avance: reservar() sólo mueve un puntero y reiniciar() la vacía
+// entera. Si una vuelta no alcanza, lo que falta va a bloques aparte y en
+// el reinicio se rehace un solo bloque del tamaño del pico, de modo que en
+// régimen no se pide memoria. Sólo para tipos trivialmente destruibles.
+class ArenaBump {
+public:
+    template <typename T>
+    T* reservar(size_t n) {
+        static_assert(std::is_trivially_destructible<T>::value, "La arena no llama destructores");
+        size_t bytes = n * sizeof(T);
+        size_t ini = (usado + alignof(T) - 1) & ~(alignof(T) - 1);
+        if (ini + bytes <= capacidad) {
+            usado = ini + bytes;
+            return reinterpret_cast<T*>(bloque.get() + ini);
         }
+        excedente += bytes + alignof(T);
+        extras.emplace_back(new char[bytes + alignof(T)]);
+        void* p = extras.back().get();
+        size_t espacio = bytes + alignof(T);
+        return reinterpret_cast<T*>(std::align(alignof(T), bytes, p, espacio));
     }
 
-public:
-    void build(std::vector<Point> points) {
-        nodes.clear();
-        rootIndex = buildTree(points);
+    void reiniciar() {
+        if (!extras.empty()) {
+            capacidad = std::max(capacidad * 2, usado + excedente);
+            bloque.reset(new char[capacidad]);
+            extras.clear();
+            excedente = 0;
+        }
+        usado = 0;
     }
 
-    Point findNearest(const Point& target) const {
-        if (rootIndex == -1) return target;
-        Point best = nodes[rootIndex].point;
-        double bestDist = std::numeric_limits<double>::max();
-        nearestNeighbor(rootIndex, target, best, bestDist);
-        return best;
-    }
+private:
+    std::unique_ptr<char[]> bloque;
+    size_t capacidad = 0, usado = 0, excedente = 0;
+    std::vector<std::unique_ptr<char[]>> extras;
 };
 
+// Asignaciones del heap en el bucle de inserción del último lote
+// (búsqueda en paralelo + retriangulación); sin contar el filtrado ni las
+// reservas del lote ni la reconstrucción de las estructuras auxiliares.
+struct EstadisticasLote { size_t puntos, asignaciones; };
+
 // ------------------------- DELAUNAY 3D OPTIMIZADO -------------------------
 class Delaunay3D {
 private:
     std::vector<Tetrahedron> tetrahedrons;
     std::vector<std::pair<Point, double>> circumsphereCache;
     std::vector<Point> points;
-    KDTree pointTree;
+    KDTreeDinamico pointTree;
     double R;
     const double eps = 1e-6;
 
@@ -179,6 +167,91 @@ private:
         }
     }
 
+    // Memoria de trabajo que se reutiliza entre inserciones y lotes: cada
+    // hilo acumula sus índices de tetraedros malos en un solo vector y la
+    // retriangulación arma las caras en la arena, que se vacía después de
+    // cada punto.
+    struct Resultado { Point punto; size_t inicio, fin; };
+    struct TrabajoHilo {
+        std::vector<size_t> malos;
+        std::vector<Resultado> resultados;
+    };
+    struct Cara {
+        std::array<Point, 3> clave;   // Vértices ordenados
+        std::array<Point, 3> cara;    // Como vienen en el tetraedro
+    };
+
+    std::vector<TrabajoHilo> trabajo;
+    std::vector<std::pair<std::array<int64_t, 3>, size_t>> clavesDedup;
+    std::vector<char> primeros;
+    std::vector<Point> uniquePoints;
+    ArenaBump arena;
+    EstadisticasLote ultimoLote{0, 0};
+
+    // `malos` son índices de la caché de circunsferas del lote, como antes
+    void insertarPunto(const Point& point, size_t* malos, size_t nMalos) {
+        // 5. Añadir el punto a la lista global
+        points.push_back(point);
+
+        // 6. Caras de los tetraedros malos; las repetidas son interiores
+        std::sort(malos, malos + nMalos);
+        Cara* caras = arena.reservar<Cara>(nMalos * 4);
+        size_t nCaras = 0;
+        auto menor = [](const Point& a, const Point& b) { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); };
+        for (size_t m = 0; m < nMalos; ++m) {
+            if (malos[m] >= tetrahedrons.size() || (m > 0 && malos[m] == malos[m - 1])) continue;
+            const auto& tet = tetrahedrons[malos[m]];
+            const std::array<Point, 3> faces[4] = {
+                {tet.p1, tet.p2, tet.p3},
+                {tet.p1, tet.p2, tet.p4},
+                {tet.p1, tet.p3, tet.p4},
+                {tet.p2, tet.p3, tet.p4}
+            };
+            for (const auto& face : faces) {
+                Cara& c = caras[nCaras++];
+                c.cara = face;
+                c.clave = face;
+                std::sort(c.clave.begin(), c.clave.end(), menor);
+            }
+        }
+        std::sort(caras, caras + nCaras, [&](const Cara& a, const Cara& b) {
+            return std::lexicographical_compare(a.clave.begin(), a.clave.end(), b.clave.begin(), b.clave.end(), menor);
+        });
+
+        // 7. Eliminar tetraedros malos (compactando en el lugar)
+        size_t escritura = 0, k = 0;
+        for (size_t i = 0; i < tetrahedrons.size(); ++i) {
+            while (k < nMalos && malos[k] < i) ++k;
+            if (k < nMalos && malos[k] == i) continue;
+            if (escritura != i) tetrahedrons[escritura] = tetrahedrons[i];
+            ++escritura;
+        }
+        tetrahedrons.resize(escritura);
+
+        // 8. Crear nuevos tetraedros desde las caras externas (aparecen una sola vez)
+        auto igual = [&](const Cara& a, const Cara& b) {
+            return !menor(a.clave[0], b.clave[0]) && !menor(b.clave[0], a.clave[0]) &&
+                   !menor(a.clave[1], b.clave[1]) && !menor(b.clave[1], a.clave[1]) &&
+                   !menor(a.clave[2], b.clave[2]) && !menor(b.clave[2], a.clave[2]);
+        };
+        for (size_t i = 0; i < nCaras;) {
+            size_t j = i + 1;
+            while (j < nCaras && igual(caras[i], caras[j])) ++j;
+            const auto& face = caras[j - 1].cara;
+            if (j - i == 1 && !(face[0] == point || face[1] == point || face[2] == point)) {
+                Tetrahedron newTet = {face[0], face[1], face[2], point};
+
+                // Verificar que los 4 puntos son distintos
+                if (!(newTet.p1 == newTet.p2 || newTet.p1 == newTet.p3 || newTet.p1 == newTet.p4 ||
+                    newTet.p2 == newTet.p3 || newTet.p2 == newTet.p4 ||
+                    newTet.p3 == newTet.p4)) {
+                    tetrahedrons.push_back(newTet);
+                }
+            }
+            i = j;
+        }
+    }
+
 public:
     Delaunay3D(double radius) : R(radius) {
         tetrahedrons.push_back(create_super_tetrahedron());
@@ -186,142 +259,106 @@ public:
         points.push_back({R, -R, -R});
         points.push_back({0, R, -R});
         points.push_back({0, 0, R});
-        pointTree.build(points);
+        pointTree.insertar(points);
         update_circumsphere_cache();
     }
 
     void add_points_batch(const std::vector<Point>& newPoints) {
-    // 1. Filtrado de puntos duplicados usando hash espacial
-    std::unordered_map<size_t, Point> spatialHash;
-    auto hashPoint = [](const Point& p) {
-        return std::hash<double>()(std::floor(p.x/1e-6))*31 ^ 
-               std::hash<double>()(std::floor(p.y/1e-6))*31 ^ 
-               std::hash<double>()(std::floor(p.z/1e-6));
-    };
-    
-    std::vector<Point> uniquePoints;
-    for (const auto& p : newPoints) {
-        size_t h = hashPoint(p);
-        if (spatialHash.find(h) == spatialHash.end()) {
-            spatialHash[h] = p;
-            uniquePoints.push_back(p);
-        }
+    // 1. Filtrado de puntos duplicados: se ordenan las claves de grilla de
+    // 1e-6 y se queda el primero de cada una, en el orden de entrada
+    clavesDedup.clear();
+    for (size_t i = 0; i < newPoints.size(); ++i) {
+        const Point& p = newPoints[i];
+        clavesDedup.push_back({{(int64_t)std::floor(p.x / 1e-6), (int64_t)std::floor(p.y / 1e-6),
+                                (int64_t)std::floor(p.z / 1e-6)}, i});
     }
-    
+    std::sort(clavesDedup.begin(), clavesDedup.end());
+    primeros.assign(newPoints.size(), 0);
+    for (size_t i = 0; i < clavesDedup.size(); ++i) {
+        if (i == 0 || clavesDedup[i].first != clavesDedup[i - 1].first) primeros[clavesDedup[i].second] = 1;
+    }
+    uniquePoints.clear();
+    for (size_t i = 0; i < newPoints.size(); ++i) {
+        if (primeros[i]) uniquePoints.push_back(newPoints[i]);
+    }
+
+    // Las reservas del lote van antes de medir; el bucle de inserción sólo
+    // reutiliza la capacidad que ya existe
+    int nHilos = omp_get_max_threads();
+    if ((int)trabajo.size() < nHilos) trabajo.resize(nHilos);
+    points.reserve(points.size() + uniquePoints.size());
+    size_t asignaciones = 0;
+
     // 2. Procesamiento paralelo de los puntos
-    #pragma omp parallel
+    #pragma omp parallel reduction(+:asignaciones)
     {
-        std::vector<std::pair<Point, std::vector<size_t>>> threadResults;
-        
-        #pragma omp for nowait
+        size_t antes = asignacionesHeap;
+        TrabajoHilo& t = trabajo[omp_get_thread_num()];
+        t.malos.clear();
+        t.resultados.clear();
+
+        #pragma omp for
         for (size_t i = 0; i < uniquePoints.size(); ++i) {
             const auto& p = uniquePoints[i];
-            std::vector<size_t> badTetrahedronIndices;
-            
+            size_t inicio = t.malos.size();
+
             // 3. Encontrar tetraedros inválidos usando la caché
             for (size_t j = 0; j < circumsphereCache.size(); ++j) {
                 const auto& [center, radius] = circumsphereCache[j];
                 double dist = std::sqrt(
-                    (p.x-center.x)*(p.x-center.x) + 
-                    (p.y-center.y)*(p.y-center.y) + 
+                    (p.x-center.x)*(p.x-center.x) +
+                    (p.y-center.y)*(p.y-center.y) +
                     (p.z-center.z)*(p.z-center.z));
                 if (dist <= radius + eps) {
-                    badTetrahedronIndices.push_back(j);
+                    t.malos.push_back(j);
                 }
             }
-            
-            if (!badTetrahedronIndices.empty()) {
-                threadResults.emplace_back(p, badTetrahedronIndices);
-            }
-        }
-        
-        // 4. Procesar los resultados de cada hilo
-        #pragma omp critical
-{
-    for (auto& [point, badIndices] : threadResults) {
-        // 5. Añadir el punto a la lista global
-        points.push_back(point);
-
-        // 6. Crear un mapa para contar las caras
-        std::unordered_map<std::string, std::array<Point, 3>> faceMap;
-        std::unordered_map<std::string, int> faceCount;
-
-        auto getFaceKey = [](const std::array<Point, 3>& face) {
-            std::array<Point, 3> sortedFace = face;
-            std::sort(sortedFace.begin(), sortedFace.end(), [](const Point& a, const Point& b) {
-                return std::tie(a.x,a.y,a.z) < std::tie(b.x,b.y,b.z);
-            });
-            return std::to_string(sortedFace[0].x)+","+std::to_string(sortedFace[0].y)+","+std::to_string(sortedFace[0].z)+"|"+
-                   std::to_string(sortedFace[1].x)+","+std::to_string(sortedFace[1].y)+","+std::to_string(sortedFace[1].z)+"|"+
-                   std::to_string(sortedFace[2].x)+","+std::to_string(sortedFace[2].y)+","+std::to_string(sortedFace[2].z);
-        };
 
-        // Recorrer tetraedros malos y contar caras
-        for (size_t idx : badIndices) {
-            const auto& tet = tetrahedrons[idx];
-            std::array<std::array<Point, 3>, 4> faces = {{
-                {tet.p1, tet.p2, tet.p3},
-                {tet.p1, tet.p2, tet.p4},
-                {tet.p1, tet.p3, tet.p4},
-                {tet.p2, tet.p3, tet.p4}
-            }};
-            for (auto& face : faces) {
-                std::string key = getFaceKey(face);
-                faceMap[key] = face;
-                faceCount[key]++;
+            if (t.malos.size() > inicio) {
+                t.resultados.push_back({p, inicio, t.malos.size()});
             }
         }
+        asignaciones += asignacionesHeap - antes;
+    }
 
-        // 7. Eliminar tetraedros malos
-        tetrahedrons.erase(
-            std::remove_if(tetrahedrons.begin(), tetrahedrons.end(),
-                [&badIndices, this](const Tetrahedron& t) {
-                    size_t index = &t - &tetrahedrons[0];
-                    return std::find(badIndices.begin(), badIndices.end(), index) != badIndices.end();
-                }),
-            tetrahedrons.end()
-        );
-
-        // 8. Crear nuevos tetraedros desde las caras externas (aparecen una sola vez)
-        for (const auto& [key, face] : faceMap) {
-            if (faceCount[key] == 1) {
-                // Validar que el tetraedro no tenga puntos repetidos
-                if (!(face[0] == point || face[1] == point || face[2] == point)) {
-                    Tetrahedron newTet = {face[0], face[1], face[2], point};
-                    
-                    // Verificar que los 4 puntos son distintos
-                    if (!(newTet.p1 == newTet.p2 || newTet.p1 == newTet.p3 || newTet.p1 == newTet.p4 ||
-                        newTet.p2 == newTet.p3 || newTet.p2 == newTet.p4 ||
-                        newTet.p3 == newTet.p4)) {
-                        tetrahedrons.push_back(newTet);
-                    }
-                }
-            }
+    // Cada tetraedro malo aporta a lo sumo 4 caras externas
+    size_t nuevosMax = 0;
+    for (int h = 0; h < nHilos; ++h)
+        for (const auto& r : trabajo[h].resultados) nuevosMax += 4 * (r.fin - r.inicio);
+    if (tetrahedrons.size() + nuevosMax > tetrahedrons.capacity())
+        tetrahedrons.reserve(std::max(tetrahedrons.size() + nuevosMax, tetrahedrons.capacity() * 2));
+
+    // 4. Procesar los resultados de cada hilo, en orden de hilo
+    size_t antes = asignacionesHeap;
+    for (int h = 0; h < nHilos; ++h) {
+        TrabajoHilo& t = trabajo[h];
+        for (const auto& r : t.resultados) {
+            insertarPunto(r.punto, t.malos.data() + r.inicio, r.fin - r.inicio);
+            arena.reiniciar();
         }
-
     }
-}
+    asignaciones += asignacionesHeap - antes;
+    ultimoLote = {uniquePoints.size(), asignaciones};
 
-    }
-    
-    // 9. Reconstruir estructuras de datos auxiliares
-    pointTree.build(points);
+    // 9. Actualizar estructuras de datos auxiliares: al índice sólo entran los puntos nuevos
+    pointTree.insertar(std::vector<Point>(points.begin() + pointTree.size(), points.end()));
     update_circumsphere_cache();
 }
 
+    EstadisticasLote get_ultimo_lote() const { return ultimoLote; }
+
+    bool touches_super_tetrahedron(const Tetrahedron& t) const {
+        Point super_vertices[4] = {{-R, -R, -R}, {R, -R, -R}, {0, R, -R}, {0, 0, R}};
+        for (const auto& sv : super_vertices) {
+            if (t.p1 == sv || t.p2 == sv || t.p3 == sv || t.p4 == sv) return true;
+        }
+        return false;
+    }
+
     void remove_super_tetrahedron() {
         tetrahedrons.erase(
             std::remove_if(tetrahedrons.begin(), tetrahedrons.end(),
-                [this](const Tetrahedron& t) {
-                    Point super_vertices[4] = {{-R, -R, -R}, {R, -R, -R}, {0, R, -R}, {0, 0, R}};
-                    int count = 0;
-                    for (const auto& sv : super_vertices) {
-                        if (t.p1 == sv || t.p2 == sv || t.p3 == sv || t.p4 == sv) {
-                            count++;
-                        }
-                    }
-                    return count > 0;
-                }),
+                [this](const Tetrahedron& t) { return touches_super_tetrahedron(t); }),
             tetrahedrons.end()
         );
         update_circumsphere_cache();
@@ -341,6 +378,20 @@ void main() {
 }
 )";
 
+// Aristas instanciadas: aPos es la línea unitaria (x en [-1, 1]) y cada
+// instancia aporta los extremos de una arista.
+const char* lineVertexShaderSource = R"(
+#version 330 core
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aStart;
+layout(location = 2) in vec3 aEnd;
+uniform mat4 MVP;
+void main() {
+    vec3 pos = mix(aStart, aEnd, aPos.x * 0.5 + 0.5);
+    gl_Position = MVP * vec4(pos, 1.0);
+}
+)";
+
 const char* fragmentShaderSource = R"(
 #version 330 core
 out vec4 FragColor;
@@ -351,9 +402,9 @@ void main() {
 )";
 
 // ------------------------- VARIABLES GLOBALES -------------------------
-GLuint shaderProgram;
+GLuint shaderProgram, shaderProgramLines;
 GLuint VAO_points, VBO_points;
-GLuint VAO_lines, VBO_lines, instanceVBO;
+GLuint VAO_lines, VBO_lines;
 Delaunay3D delaunay3d(2);//0.675
 
 // Control de cámara
@@ -362,6 +413,198 @@ float lastX = 400, lastY = 300;
 float zoom = 10.0f;
 bool firstMouse = true;
 
+// ------------------------- ANILLO DE SUBIDA -------------------------
+// Un buffer grande que se llena en círculo para las subidas que cambian
+// todo el tiempo. Con GL 4.4 o ARB_buffer_storage queda mapeado de forma
+// persistente y coherente, y se escribe directo en él. En GL 3.3 cada
+// reserva se mapea sin sincronizar, y cuando hay que dar la vuelta sin
+// regiones vivas se huérfana el buffer en lugar de esperar. Una región
+// liberada se reutiliza recién cuando pasa la cerca (glFenceSync) del
+// cuadro en que se liberó: nunca se pisa algo que la GPU todavía lee y el
+// driver no realoca memoria. Si lo que no deja lugar son regiones todavía
+// en uso, se pasa a un buffer nuevo del doble y el viejo queda retirado
+// hasta que terminan sus regiones.
+const size_t TAM_ANILLO = 64u << 20;
+
+class AnilloSubida {
+public:
+    struct Region { GLuint buffer; size_t offset, bytes; void* datos; };
+
+    void crear(size_t bytes) {
+        persistente = GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage;
+        capacidad = bytes;
+        cabeza = 0;
+        glGenBuffers(1, &id);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+        if (persistente) {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_COPY_WRITE_BUFFER, capacidad, nullptr, flags);
+            mapa = static_cast<char*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, capacidad, flags));
+        } else {
+            glBufferData(GL_COPY_WRITE_BUFFER, capacidad, nullptr, GL_STREAM_DRAW);
+        }
+    }
+
+    void destruir() {
+        borrar(id, mapa, regiones);
+        for (auto& v : retirados) borrar(v.id, v.mapa, v.regiones);
+        retirados.clear();
+    }
+
+    // Región contigua y escribible de `bytes`. Si el anillo no alcanza ni
+    // vacío, o las regiones en uso no dejan lugar, se pasa a un buffer nuevo
+    // del doble: `buffer()` cambia, así que la región dice en cuál quedó.
+    Region reservar(size_t bytes) {
+        bytes = (bytes + 15) & ~size_t(15);
+        recuperar(false);
+        size_t offset;
+        while (!hueco(bytes, offset)) {
+            bool todasLiberadas = std::all_of(regiones.begin(), regiones.end(), [](const Viva& r) { return r.liberada; });
+            if (regiones.empty()) {
+                crecer(bytes);
+            } else if (!persistente && todasLiberadas) {
+                // Huérfano: la GPU termina con el almacenamiento viejo y acá empieza uno nuevo
+                for (auto& r : regiones) if (r.cerca) glDeleteSync(r.cerca);
+                regiones.clear();
+                glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+                glBufferData(GL_COPY_WRITE_BUFFER, capacidad, nullptr, GL_STREAM_DRAW);
+                cabeza = 0;
+            } else if (regiones.front().liberada) {
+                recuperar(true);
+            } else {
+                crecer(bytes);
+            }
+        }
+
+        regiones.push_back({offset, bytes, false, 0});
+        cabeza = offset + bytes;
+        void* datos;
+        if (persistente) {
+            datos = mapa + offset;
+        } else {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, id);
+            datos = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, bytes,
+                                     GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        }
+        return {id, offset, bytes, datos};
+    }
+
+    // Fin de la escritura; con el mapeo coherente no hace falta nada
+    void confirmar(const Region& region) {
+        if (persistente) return;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, region.buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    }
+
+    // La región no se vuelve a usar después de los comandos ya emitidos
+    void liberar(const Region& region) {
+        std::deque<Viva>* rs = &regiones;
+        if (region.buffer != id) {
+            auto v = std::find_if(retirados.begin(), retirados.end(), [&](const Retirado& v) { return v.id == region.buffer; });
+            if (v == retirados.end()) return;
+            rs = &v->regiones;
+        }
+        for (auto& r : *rs) if (r.offset == region.offset && !r.liberada) { r.liberada = true; return; }
+    }
+
+    // Cerca para lo liberado en este cuadro; llamar después de emitir sus comandos
+    void finCuadro() {
+        auto cercar = [](std::deque<Viva>& rs) {
+            for (auto& r : rs) if (r.liberada && !r.cerca) r.cerca = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        };
+        cercar(regiones);
+        for (auto& v : retirados) cercar(v.regiones);
+    }
+
+    GLuint buffer() const { return id; }
+
+private:
+    struct Viva { size_t offset, bytes; bool liberada; GLsync cerca; };
+    // Buffer reemplazado por crecer() que todavía tiene regiones en uso
+    struct Retirado { GLuint id; char* mapa; std::deque<Viva> regiones; };
+
+    GLuint id = 0;
+    char* mapa = nullptr;
+    bool persistente = false;
+    size_t capacidad = 0, cabeza = 0;
+    std::deque<Viva> regiones;   // En orden de reserva
+    std::vector<Retirado> retirados;
+
+    static void borrar(GLuint& buffer, char*& mapeo, std::deque<Viva>& rs) {
+        for (auto& r : rs) if (r.cerca) glDeleteSync(r.cerca);
+        rs.clear();
+        if (mapeo) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+            mapeo = nullptr;
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+
+    // Pasa a un buffer nuevo de al menos el doble y `bytes`; el actual se
+    // borra si está vacío o queda retirado hasta que terminan sus regiones
+    void crecer(size_t bytes) {
+        size_t nueva = std::max(capacidad * 2, bytes);
+        if (regiones.empty()) borrar(id, mapa, regiones);
+        else retirados.push_back({id, mapa, std::move(regiones)});
+        regiones.clear();
+        id = 0;
+        mapa = nullptr;
+        crear(nueva);
+    }
+
+    // Devuelve las regiones del frente ya terminadas; con `bloquear` espera la
+    // primera. Los retirados se borran cuando pasan las cercas de todas las suyas.
+    void recuperar(bool bloquear) {
+        for (size_t i = 0; i < retirados.size(); ) {
+            Retirado& v = retirados[i];
+            // Ya no se reserva en ellos, así que sus regiones terminan en cualquier orden
+            v.regiones.erase(std::remove_if(v.regiones.begin(), v.regiones.end(), [](const Viva& r) {
+                if (!r.cerca) return false;
+                GLenum estado = glClientWaitSync(r.cerca, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+                if (estado == GL_TIMEOUT_EXPIRED || estado == GL_WAIT_FAILED) return false;
+                glDeleteSync(r.cerca);
+                return true;
+            }), v.regiones.end());
+            if (v.regiones.empty()) {
+                borrar(v.id, v.mapa, v.regiones);
+                retirados.erase(retirados.begin() + i);
+            } else {
+                ++i;
+            }
+        }
+
+        while (!regiones.empty() && regiones.front().liberada) {
+            Viva& r = regiones.front();
+            if (!r.cerca) {
+                if (!bloquear) return;
+                r.cerca = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            }
+            GLenum estado = glClientWaitSync(r.cerca, GL_SYNC_FLUSH_COMMANDS_BIT, bloquear ? 1000000000ull : 0);
+            if (estado == GL_TIMEOUT_EXPIRED || estado == GL_WAIT_FAILED) return;
+            glDeleteSync(r.cerca);
+            regiones.pop_front();
+            bloquear = false;
+        }
+        if (regiones.empty()) cabeza = 0;
+    }
+
+    bool hueco(size_t bytes, size_t& offset) {
+        if (regiones.empty()) { offset = 0; return bytes <= capacidad; }
+        size_t frente = regiones.front().offset;
+        if (frente < cabeza) {
+            if (capacidad - cabeza >= bytes) { offset = cabeza; return true; }
+            if (frente >= bytes) { offset = 0; return true; }
+            return false;
+        }
+        if (frente - cabeza >= bytes) { offset = cabeza; return true; }
+        return false;
+    }
+};
+
+AnilloSubida anillo;
+
 // ------------------------- FUNCIONES AUXILIARES -------------------------
 GLuint compileShader(GLenum type, const char* src) {
     GLuint shader = glCreateShader(type);
@@ -377,9 +620,9 @@ GLuint compileShader(GLenum type, const char* src) {
     return shader;
 }
 
-GLuint createShaderProgram() {
-    GLuint vs = compileShader(GL_VERTEX_SHADER, vertexShaderSource);
-    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+GLuint createShaderProgram(const char* vsSrc, const char* fsSrc) {
+    GLuint vs = compileShader(GL_VERTEX_SHADER, vsSrc);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, fsSrc);
     GLuint program = glCreateProgram();
     glAttachShader(program, vs);
     glAttachShader(program, fs);
@@ -426,8 +669,17 @@ std::vector<Point> leerPuntosNormalizados(const std::string& ruta) {
     return pts;
 }
 
+// Apunta los atributos por instancia de VAO_lines a `offset` dentro del anillo
+void enlazarInstancias(GLuint buffer, size_t offset) {
+    glBindVertexArray(VAO_lines);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)offset);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(offset + 3 * sizeof(float)));
+}
+
 void initOpenGL() {
-    shaderProgram = createShaderProgram();
+    shaderProgram = createShaderProgram(vertexShaderSource, fragmentShaderSource);
+    shaderProgramLines = createShaderProgram(lineVertexShaderSource, fragmentShaderSource);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 
     // VAO/VBO para puntos
@@ -441,7 +693,6 @@ void initOpenGL() {
     // VAO/VBO para líneas con instancing
     glGenVertexArrays(1, &VAO_lines);
     glGenBuffers(1, &VBO_lines);
-    glGenBuffers(1, &instanceVBO);
     
     glBindVertexArray(VAO_lines);
     
@@ -452,59 +703,204 @@ void initOpenGL() {
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
 
-    // Buffer de instancias para las transformaciones de las líneas
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    // Los atributos 1 y 2 serán para start y end de cada arista
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    // Los atributos 1 y 2 serán para start y end de cada arista; los datos
+    // por instancia viven en el anillo de subida (ver recibirEntrega)
+    anillo.crear(TAM_ANILLO);
+    enlazarInstancias(anillo.buffer(), 0);
     glVertexAttribDivisor(1, 1);
-    
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
     glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
 
     glEnable(GL_DEPTH_TEST);
     glPointSize(5.0f);
     glLineWidth(1.0f);
 }
-int numLineVertices = 0;
 
-void updateBuffers() {
-    // Datos de puntos
-    std::vector<float> pointData;
-    for (const auto& p : delaunay3d.get_points()) {
-        pointData.push_back(static_cast<float>(p.x));
-        pointData.push_back(static_cast<float>(p.y));
-        pointData.push_back(static_cast<float>(p.z));
+// ------------------------- TRIANGULACIÓN EN SEGUNDO PLANO -------------------------
+// Un hilo trabajador triangula órgano por órgano en lotes de
+// PUNTOS_POR_ENTREGA y deja Entregas en un buzón de un solo lugar
+// (std::atomic<Entrega*>). Los puntos sólo crecen, así que viajan como
+// delta desde la entrega anterior. Las aristas salen de recorrer la malla
+// entera (copiar, indexar y deduplicar), que crece con cada lote, así que
+// no viajan en todas: las llevan una de cada ENTREGAS_POR_ARISTAS, la del
+// final de cada órgano y la final. Entre medio el render sigue dibujando
+// las últimas que recibió. El render toma la entrega con exchange, sin
+// bloquear nunca.
+const size_t PUNTOS_POR_ENTREGA = 5000;
+const double INTERVALO_ENTREGA_MS = 100.0;
+const size_t ENTREGAS_POR_ARISTAS = 10;
+
+struct Entrega {
+    size_t primerPunto;           // Índice global del primer punto de `puntos`
+    std::vector<float> puntos;    // x, y, z de los puntos nuevos
+    bool conAristas;              // Si no, las aristas anteriores siguen valiendo
+    std::vector<float> aristas;   // Extremos (x, y, z, x, y, z) de cada arista única
+    size_t nTetraedros;
+    bool final;
+};
+
+std::atomic<Entrega*> buzon{nullptr};
+std::atomic<bool> cancelarTriangulacion{false};
+size_t puntosPublicados = 0;      // Sólo lo toca el hilo trabajador
+std::chrono::steady_clock::time_point ultimaEntrega; // Ídem
+size_t entregasSinAristas = 0;    // Ídem
+
+Entrega* armarEntrega(bool conAristas, bool final) {
+    const auto& pts = delaunay3d.get_points();
+    conAristas = conAristas || final;
+    Entrega* e = new Entrega{puntosPublicados, {}, conAristas, {}, 0, final};
+    e->puntos.reserve((pts.size() - puntosPublicados) * 3);
+    for (size_t i = puntosPublicados; i < pts.size(); ++i)
+        e->puntos.insert(e->puntos.end(), {(float)pts[i].x, (float)pts[i].y, (float)pts[i].z});
+    puntosPublicados = pts.size();
+
+    // Las intermedias cuentan también los tetraedros del supertetraedro
+    const auto& tets = delaunay3d.get_tetrahedrons();
+    e->nTetraedros = tets.size();
+    if (!conAristas) return e;
+    entregasSinAristas = 0;
+
+    // Mientras el supertetraedro siga en la malla, sus tetraedros no se muestran
+    std::vector<Tetrahedron> interior;
+    if (!final) {
+        interior.reserve(tets.size());
+        for (const auto& t : tets)
+            if (!delaunay3d.touches_super_tetrahedron(t)) interior.push_back(t);
     }
+    std::vector<Point> vertices = pts;
+    std::vector<GLuint> lineIndices = extraerAristasUnicas(indexarTetraedros(vertices, final ? tets : interior));
+
+    e->aristas.resize(lineIndices.size() * 3);
+    #pragma omp parallel for
+    for (size_t i = 0; i < lineIndices.size(); ++i) {
+        const Point& p = vertices[lineIndices[i]];
+        e->aristas[i * 3] = static_cast<float>(p.x);
+        e->aristas[i * 3 + 1] = static_cast<float>(p.y);
+        e->aristas[i * 3 + 2] = static_cast<float>(p.z);
+    }
+    return e;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_points);
-    glBufferData(GL_ARRAY_BUFFER, pointData.size() * sizeof(float), pointData.data(), GL_STATIC_DRAW);
+// Productor único: si el render no tomó la entrega anterior (sólo puede
+// pasar con las de fin de órgano y la final), se recupera y sus puntos se
+// anteponen a los de la nueva para no perder el delta; sus aristas pasan a
+// la nueva si ésta no trae.
+void publicar(Entrega* nueva) {
+    if (Entrega* vieja = buzon.exchange(nullptr)) {
+        vieja->puntos.insert(vieja->puntos.end(), nueva->puntos.begin(), nueva->puntos.end());
+        nueva->puntos.swap(vieja->puntos);
+        nueva->primerPunto = vieja->primerPunto;
+        if (!nueva->conAristas && vieja->conAristas) {
+            nueva->aristas.swap(vieja->aristas);
+            nueva->conAristas = true;
+        }
+        delete vieja;
+    }
+    buzon.store(nueva);
+}
 
-    // Datos para las aristas (sin instancing)
-    std::vector<float> edgeVertices;
-    for (const auto& t : delaunay3d.get_tetrahedrons()) {
-        const Point* pts[] = {&t.p1, &t.p2, &t.p3, &t.p4};
-        int edges[6][2] = {{0,1},{0,2},{0,3},{1,2},{1,3},{2,3}};
-        
-        for (const auto& e : edges) {
-            edgeVertices.push_back(static_cast<float>(pts[e[0]]->x));
-            edgeVertices.push_back(static_cast<float>(pts[e[0]]->y));
-            edgeVertices.push_back(static_cast<float>(pts[e[0]]->z));
-            edgeVertices.push_back(static_cast<float>(pts[e[1]]->x));
-            edgeVertices.push_back(static_cast<float>(pts[e[1]]->y));
-            edgeVertices.push_back(static_cast<float>(pts[e[1]]->z));
+// Después de un lote no se arma nada si el render todavía no tomó la
+// entrega anterior o si pasaron menos de INTERVALO_ENTREGA_MS desde la
+// última; los puntos pendientes viajan en la siguiente.
+bool tocaEntrega() {
+    if (buzon.load() != nullptr) return false;
+    auto ahora = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double, std::milli>(ahora - ultimaEntrega).count() < INTERVALO_ENTREGA_MS) return false;
+    ultimaEntrega = ahora;
+    return true;
+}
+
+void triangularEnSegundoPlano(std::vector<std::string> rutas) {
+    try {
+        bool primerLote = true;
+        for (const auto& ruta : rutas) {
+            auto puntos = leerPuntosNormalizados(ruta);
+            size_t lotes = 0, asignaciones = 0;
+            for (size_t i = 0; i < puntos.size(); i += PUNTOS_POR_ENTREGA) {
+                if (cancelarTriangulacion) return;
+                std::vector<Point> lote(puntos.begin() + i, puntos.begin() + std::min(i + PUNTOS_POR_ENTREGA, puntos.size()));
+                delaunay3d.add_points_batch(lote);
+                // El primer lote de todos dimensiona la memoria de trabajo y no cuenta
+                if (!primerLote) asignaciones += delaunay3d.get_ultimo_lote().asignaciones;
+                primerLote = false;
+                ++lotes;
+                if (tocaEntrega()) publicar(armarEntrega(++entregasSinAristas >= ENTREGAS_POR_ARISTAS, false));
+            }
+            std::cout << ruta << ": " << lotes << " lotes, " << asignaciones << " asignaciones en la inserción\n";
+            // Órgano terminado: sus aristas se ven aunque el render esté atrasado
+            if (&ruta != &rutas.back()) publicar(armarEntrega(true, false));
         }
+        delaunay3d.remove_super_tetrahedron();
+        std::cout << "Total tetraedros: " << delaunay3d.get_tetrahedrons().size() << std::endl;
+        publicar(armarEntrega(true, true));
+    } catch (const std::exception& e) {
+        std::cerr << "Error en la triangulación: " << e.what() << "\n";
     }
+}
 
-    glBindVertexArray(VAO_lines);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_lines);
-    glBufferData(GL_ARRAY_BUFFER, edgeVertices.size() * sizeof(float), edgeVertices.data(), GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+// Lado del render: los puntos nuevos se agregan al final de VBO_points
+// (que crece al doble cuando hace falta) pasando por el anillo, y las
+// aristas, cuando vienen, se escriben en una región nueva del anillo a la
+// que se apuntan los atributos por instancia. La región anterior se libera
+// y se recicla cuando la GPU termina el cuadro que todavía la dibuja.
+int numEdges = 0;
+AnilloSubida::Region regionAristas{};
+bool hayAristas = false;
+size_t puntosSubidos = 0, capacidadPuntos = 0;
+size_t numTetraedros = 0;
+bool triangulacionTerminada = false;
+
+void recibirEntrega() {
+    Entrega* e = buzon.exchange(nullptr);
+    if (!e) return;
+
+    size_t n = e->puntos.size() / 3;
+    if (e->primerPunto + n > capacidadPuntos) {
+        size_t nuevaCapacidad = std::max({capacidadPuntos * 2, e->primerPunto + n, (size_t)1024});
+        GLuint nuevo;
+        glGenBuffers(1, &nuevo);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, nuevo);
+        glBufferData(GL_COPY_WRITE_BUFFER, nuevaCapacidad * 3 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_READ_BUFFER, VBO_points);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, puntosSubidos * 3 * sizeof(float));
+        glDeleteBuffers(1, &VBO_points);
+        VBO_points = nuevo;
+        capacidadPuntos = nuevaCapacidad;
 
-    // Guardar el total de vértices de las líneas
-    numLineVertices = edgeVertices.size() / 3;
+        glBindVertexArray(VAO_points);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO_points);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+        glBindVertexArray(0);
+    }
+    if (n > 0) {
+        size_t bytes = e->puntos.size() * sizeof(float);
+        AnilloSubida::Region r = anillo.reservar(bytes);
+        std::memcpy(r.datos, e->puntos.data(), bytes);
+        anillo.confirmar(r);
+        glBindBuffer(GL_COPY_READ_BUFFER, r.buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, VBO_points);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, r.offset, e->primerPunto * 3 * sizeof(float), bytes);
+        anillo.liberar(r);
+    }
+    puntosSubidos = e->primerPunto + n;
+
+    if (e->conAristas) {
+        if (hayAristas) anillo.liberar(regionAristas);
+        hayAristas = !e->aristas.empty();
+        if (hayAristas) {
+            size_t bytes = e->aristas.size() * sizeof(float);
+            regionAristas = anillo.reservar(bytes);
+            std::memcpy(regionAristas.datos, e->aristas.data(), bytes);
+            anillo.confirmar(regionAristas);
+            enlazarInstancias(regionAristas.buffer, regionAristas.offset);
+            glBindVertexArray(0);
+        }
+        numEdges = e->aristas.size() / 6;
+    }
+    numTetraedros = e->nTetraedros;
+    triangulacionTerminada = e->final;
+    delete e;
 }
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
@@ -531,10 +927,18 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
 }
 
 void render(GLFWwindow* window) {
-    std::cout << "Dibujando " << delaunay3d.get_points().size() << " puntos y " << numLineVertices/2 << " líneas.\n";
-
+    bool terminadaAntes = false;
     while (!glfwWindowShouldClose(window)) {
-        
+        recibirEntrega();
+        if (triangulacionTerminada != terminadaAntes || !triangulacionTerminada) {
+            std::ostringstream titulo;
+            titulo << (triangulacionTerminada ? "Delaunay 3D: " : "Delaunay 3D (triangulando): ")
+                   << puntosSubidos << " puntos, " << numTetraedros << " tetraedros, " << numEdges << " aristas";
+            glfwSetWindowTitle(window, titulo.str().c_str());
+            if (triangulacionTerminada) std::cout << "Dibujando " << puntosSubidos << " puntos y " << numEdges << " líneas.\n";
+            terminadaAntes = triangulacionTerminada;
+        }
+
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glUseProgram(shaderProgram);
 
@@ -555,15 +959,17 @@ void render(GLFWwindow* window) {
         GLuint colorLoc = glGetUniformLocation(shaderProgram, "color");
         glUniform3f(colorLoc, 1.0f, 0.0f, 0.0f);
         glBindVertexArray(VAO_points);
-        glDrawArrays(GL_POINTS, 0, delaunay3d.get_points().size());
+        glDrawArrays(GL_POINTS, 0, puntosSubidos);
 
-        // Dibujar aristas con instancing
-        // Dibujar aristas
-        glUniform3f(colorLoc, 0.0f, 1.0f, 0.0f);
+        // Dibujar aristas con instancing: una línea unitaria por arista
+        glUseProgram(shaderProgramLines);
+        glUniformMatrix4fv(glGetUniformLocation(shaderProgramLines, "MVP"), 1, GL_FALSE, glm::value_ptr(MVP));
+        glUniform3f(glGetUniformLocation(shaderProgramLines, "color"), 0.0f, 1.0f, 0.0f);
         glBindVertexArray(VAO_lines);
-        glDrawArrays(GL_LINES, 0, numLineVertices);
+        glDrawArraysInstanced(GL_LINES, 0, 2, numEdges);
 
         //std::cout << "Dibujando " << delaunay3d.get_tetrahedrons().size() * 6 << " aristas.\n";
+        anillo.finCuadro();
 
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -608,12 +1014,10 @@ int main() {
     "puntos_separados/puntos_tiff_spleenMasks.txt",
     "puntos_separados/puntos_tiff_stomachMasks.txt"};
 
-    
-    for(int i = 0; i < nombrePuntoSeparado.size(); i++) {
-        std::string rutaCompleta = pathSeparados + "/" + nombrePunto[i];
-        auto puntos = leerPuntosNormalizados(rutaCompleta);
-        delaunay3d.add_points_batch(puntos);
-    }
+
+    // La triangulación corre en segundo plano; la malla aparece a medida que se construye
+    std::thread trabajador(triangularEnSegundoPlano, nombrePuntoSeparado);
+
     // Procesamiento por lotes optimizado
      std::vector<Point> normales ={
         {0.0, 0.0, 0.0},
@@ -639,7 +1043,6 @@ int main() {
    
     //delaunay3d.add_points_batch(puntos);
     
-    std::cout << "Total tetraedros: " << delaunay3d.get_tetrahedrons().size() << std::endl;
     /*
     for (const auto& t : delaunay3d.get_tetrahedrons()) {
         std::cout << "(" << t.p1.x << "," << t.p1.y << "," << t.p1.z << ") - "
@@ -651,16 +1054,21 @@ int main() {
     
 
     //delaunay3d.add_points_batch(puntos);
-    delaunay3d.remove_super_tetrahedron();
     
     // Inicializar GLFW y OpenGL
-    if (!glfwInit()) return -1;
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    
-    GLFWwindow* window = glfwCreateWindow(800, 600, "Delaunay 3D Ultra Optimizado", NULL, NULL);
-    if (!window) { glfwTerminate(); return -1; }
+    GLFWwindow* window = nullptr;
+    if (glfwInit()) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        window = glfwCreateWindow(800, 600, "Delaunay 3D Ultra Optimizado", NULL, NULL);
+    }
+    if (!window) {
+        cancelarTriangulacion = true;
+        trabajador.join();
+        glfwTerminate();
+        return -1;
+    }
     
     glfwMakeContextCurrent(window);
     gladLoadGLLoader((GLADloadproc)glfwGetProcAddress);
@@ -672,16 +1080,21 @@ int main() {
 
     // Inicializar y renderizar
     initOpenGL();
-    updateBuffers();
     render(window);
 
+    // El lote en curso termina antes de que el hilo vea la cancelación
+    cancelarTriangulacion = true;
+    trabajador.join();
+    delete buzon.exchange(nullptr);
+
     // Limpieza
     glDeleteVertexArrays(1, &VAO_points);
     glDeleteBuffers(1, &VBO_points);
     glDeleteVertexArrays(1, &VAO_lines);
     glDeleteBuffers(1, &VBO_lines);
-    glDeleteBuffers(1, &instanceVBO);
+    anillo.destruir();
     glDeleteProgram(shaderProgram);
+    glDeleteProgram(shaderProgramLines);
     glfwTerminate();
     return 0;
 }
\ No newline at end of file
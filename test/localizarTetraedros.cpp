@@ -0,0 +1,140 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <stdexcept>
+#include <omp.h>
+
+#include "../output/mallaComun.h"
+#include "../output/localizador.h"
+
+// ------------------------- PARÁMETROS -------------------------
+// Localiza consultas al azar en una malla terminada con
+// LocalizadorTetraedros::localizarLote y compara una muestra contra la
+// prueba baricéntrica de fuerza bruta sobre todos los tetraedros. Las
+// consultas salen de la caja de los vértices agrandada un MARGEN_CAJA, así
+// que también hay puntos fuera de la malla.
+const size_t CONSULTAS_POR_DEFECTO = 1000000;
+const size_t MUESTRA_POR_DEFECTO = 200;
+const double MARGEN_CAJA = 0.05;
+const double TOLERANCIA = 1e-9;   // Baricéntrica mínima para contar como adentro
+
+// ------------------------- FUERZA BRUTA -------------------------
+double orientacion(const Point& a, const Point& b, const Point& c, const Point& d) {
+    double bx = b.x - a.x, by = b.y - a.y, bz = b.z - a.z;
+    double cx = c.x - a.x, cy = c.y - a.y, cz = c.z - a.z;
+    double dx = d.x - a.x, dy = d.y - a.y, dz = d.z - a.z;
+    return bx * (cy * dz - cz * dy) - by * (cx * dz - cz * dx) + bz * (cx * dy - cy * dx);
+}
+
+// Baricéntricas de p respecto de p1..p4; false si el tetraedro es plano
+bool baricentricas(const Tetrahedron& t, const Point& p, double b[4]) {
+    double vol = orientacion(t.p1, t.p2, t.p3, t.p4);
+    if (vol == 0.0) return false;
+    b[0] = orientacion(p, t.p2, t.p3, t.p4) / vol;
+    b[1] = orientacion(t.p1, p, t.p3, t.p4) / vol;
+    b[2] = orientacion(t.p1, t.p2, p, t.p4) / vol;
+    b[3] = orientacion(t.p1, t.p2, t.p3, p) / vol;
+    return true;
+}
+
+bool contiene(const Tetrahedron& t, const Point& p) {
+    double b[4];
+    return baricentricas(t, p, b) && *std::min_element(b, b + 4) >= -TOLERANCIA;
+}
+
+// Primer tetraedro que contiene a p, -1 si ninguno
+int64_t buscarFuerzaBruta(const std::vector<Tetrahedron>& tets, const Point& p) {
+    int64_t r = -1;
+    #pragma omp parallel for
+    for (size_t t = 0; t < tets.size(); ++t) {
+        if (!contiene(tets[t], p)) continue;
+        #pragma omp critical
+        if (r < 0 || (int64_t)t < r) r = t;
+    }
+    return r;
+}
+
+// ------------------------- MAIN -------------------------
+// Uso: localizarTetraedros <malla.bin> [consultas] [muestra]
+// Termina con 1 si alguna consulta de la muestra no coincide.
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Uso: localizarTetraedros <malla.bin> [consultas] [muestra]\n";
+        return 1;
+    }
+    try {
+        std::string ruta = argv[1];
+        size_t nConsultas = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : CONSULTAS_POR_DEFECTO;
+        size_t nMuestra = std::min<size_t>(argc > 3 ? std::strtoull(argv[3], nullptr, 10) : MUESTRA_POR_DEFECTO, nConsultas);
+
+        std::vector<Point> points;
+        std::vector<Tetrahedron> tets;
+        leerBin(ruta, points, tets);
+        if (tets.empty()) throw std::runtime_error("La malla no tiene tetraedros: " + ruta);
+
+        auto t0 = std::chrono::steady_clock::now();
+        LocalizadorTetraedros localizador(tets);
+        double msIndexar = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        Point mn = tets[0].p1, mx = tets[0].p1;
+        for (const auto& t : tets) {
+            for (const Point* v : {&t.p1, &t.p2, &t.p3, &t.p4}) {
+                mn = {std::min(mn.x, v->x), std::min(mn.y, v->y), std::min(mn.z, v->z)};
+                mx = {std::max(mx.x, v->x), std::max(mx.y, v->y), std::max(mx.z, v->z)};
+            }
+        }
+        std::mt19937_64 gen(12345);
+        auto eje = [&](double a, double b) {
+            double m = (b - a) * MARGEN_CAJA;
+            return std::uniform_real_distribution<double>(a - m, b + m)(gen);
+        };
+        std::vector<Point> consultas(nConsultas);
+        for (auto& q : consultas) q = {eje(mn.x, mx.x), eje(mn.y, mx.y), eje(mn.z, mx.z)};
+
+        t0 = std::chrono::steady_clock::now();
+        std::vector<Localizacion> r = localizador.localizarLote(consultas);
+        double msLote = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        size_t adentro = std::count_if(r.begin(), r.end(), [](const Localizacion& l) { return l.tetraedro >= 0; });
+        std::cout << ruta << ": " << tets.size() << " tetraedros, índice en " << msIndexar << " ms\n"
+                  << nConsultas << " consultas (" << adentro << " adentro) en " << msLote << " ms: "
+                  << (msLote > 0.0 ? nConsultas / (msLote / 1000.0) : 0.0) << " consultas/s\n";
+
+        // La muestra se compara contra fuerza bruta. En una cara compartida
+        // valen los dos tetraedros, así que se pide que el devuelto contenga
+        // al punto, no que sea el mismo índice.
+        size_t errores = 0;
+        for (size_t s = 0; s < nMuestra; ++s) {
+            size_t i = s * (nConsultas / nMuestra);
+            const Point& q = consultas[i];
+            const Localizacion& l = r[i];
+            int64_t esperado = buscarFuerzaBruta(tets, q);
+
+            std::string problema;
+            if (l.tetraedro < 0 && esperado >= 0) {
+                problema = "afuera según el localizador, adentro del tetraedro " + std::to_string(esperado);
+            } else if (l.tetraedro >= 0 && !contiene(tets[l.tetraedro], q)) {
+                problema = "el tetraedro " + std::to_string(l.tetraedro) + " no lo contiene";
+            } else if (l.tetraedro >= 0) {
+                double b[4];
+                baricentricas(tets[l.tetraedro], q, b);
+                for (int k = 0; k < 4; ++k)
+                    if (std::abs(b[k] - l.baricentricas[k]) > 1e-6) problema = "baricéntricas distintas";
+            }
+            if (problema.empty()) continue;
+            if (++errores <= 10)
+                std::cerr << "Consulta " << i << " (" << q.x << ", " << q.y << ", " << q.z << "): " << problema << "\n";
+        }
+        std::cout << "Muestra: " << nMuestra - errores << "/" << nMuestra << " coinciden con fuerza bruta\n";
+        return errores == 0 ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        return 1;
+    }
+}
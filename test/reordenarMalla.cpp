@@ -0,0 +1,166 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <tuple>
+#include <chrono>
+#include <deque>
+#include <cstdint>
+#include <stdexcept>
+#include <omp.h>
+
+#include "../output/mallaComun.h"
+
+// ------------------------- PARÁMETROS -------------------------
+// Los vértices se ordenan por código Morton de 63 bits (21 por eje) sobre la
+// caja de la parte y los tetraedros por sus índices nuevos, del menor al
+// mayor: vértices cercanos en el espacio quedan cercanos en el archivo y
+// cada tetraedro cae junto a sus vecinos. El formato del .bin no cambia.
+const int BITS_MORTON = 21;
+const size_t TAM_CACHE_VERTICES = 32;   // FIFO típico de post-transformación
+const int REPETICIONES = 3;
+
+// ------------------------- REORDENAMIENTO -------------------------
+// Intercala 21 bits por eje
+uint64_t expandirBits(uint64_t v) {
+    v &= 0x1fffff;
+    v = (v | v << 32) & 0x1f00000000ffffull;
+    v = (v | v << 16) & 0x1f0000ff0000ffull;
+    v = (v | v << 8)  & 0x100f00f00f00f00full;
+    v = (v | v << 4)  & 0x10c30c30c30c30c3ull;
+    v = (v | v << 2)  & 0x1249249249249249ull;
+    return v;
+}
+
+void reordenar(std::vector<Point>& points, std::vector<Tetrahedron>& tets) {
+    std::vector<uint32_t> indices = indexarTetraedros(points, tets);
+    size_t n = points.size();
+    if (n == 0) return;
+
+    double mn[3] = {1e300, 1e300, 1e300}, mx[3] = {-1e300, -1e300, -1e300};
+    for (const auto& p : points) {
+        const double c[3] = {p.x, p.y, p.z};
+        for (int k = 0; k < 3; ++k) { mn[k] = std::min(mn[k], c[k]); mx[k] = std::max(mx[k], c[k]); }
+    }
+    const double maxCelda = (double)((1u << BITS_MORTON) - 1);
+    std::vector<std::pair<uint64_t, uint32_t>> codigos(n);
+    #pragma omp parallel for
+    for (size_t i = 0; i < n; ++i) {
+        const double c[3] = {points[i].x, points[i].y, points[i].z};
+        uint64_t q[3];
+        for (int k = 0; k < 3; ++k) {
+            double ext = mx[k] - mn[k];
+            q[k] = ext > 0.0 ? (uint64_t)((c[k] - mn[k]) / ext * maxCelda) : 0;
+        }
+        codigos[i] = {(expandirBits(q[0]) << 2) | (expandirBits(q[1]) << 1) | expandirBits(q[2]), (uint32_t)i};
+    }
+    std::sort(codigos.begin(), codigos.end());
+
+    std::vector<Point> ordenados(n);
+    std::vector<uint32_t> nuevoIndice(n);
+    for (size_t i = 0; i < n; ++i) {
+        ordenados[i] = points[codigos[i].second];
+        nuevoIndice[codigos[i].second] = i;
+    }
+    points.swap(ordenados);
+
+    // Clave de cada tetraedro: sus cuatro índices nuevos de menor a mayor.
+    // Los vértices dentro del tetraedro conservan su orden (y orientación).
+    std::vector<std::pair<std::array<uint32_t, 4>, uint32_t>> claves(tets.size());
+    #pragma omp parallel for
+    for (size_t t = 0; t < tets.size(); ++t) {
+        std::array<uint32_t, 4> k;
+        for (int j = 0; j < 4; ++j) k[j] = nuevoIndice[indices[t * 4 + j]];
+        std::sort(k.begin(), k.end());
+        claves[t] = {k, (uint32_t)t};
+    }
+    std::sort(claves.begin(), claves.end());
+
+    std::vector<Tetrahedron> tetsOrdenados(tets.size());
+    for (size_t t = 0; t < tets.size(); ++t) tetsOrdenados[t] = tets[claves[t].second];
+    tets.swap(tetsOrdenados);
+}
+
+// ------------------------- MEDICIÓN -------------------------
+// Dos medidas de localidad: el tiempo de indexar y extraer aristas (lo que
+// hacen los visores al cargar) y la tasa de aciertos de una caché FIFO de
+// TAM_CACHE_VERTICES sobre el flujo de índices de los tetraedros, como la
+// caché de post-transformación de la GPU.
+struct Medida { double msAristas; double aciertos; size_t nAristas; };
+
+Medida medir(const std::vector<Point>& points, const std::vector<Tetrahedron>& tets) {
+    Medida m{1e300, 0.0, 0};
+    std::vector<uint32_t> indices;
+    for (int r = 0; r < REPETICIONES; ++r) {
+        std::vector<Point> copia = points;
+        auto t0 = std::chrono::steady_clock::now();
+        indices = indexarTetraedros(copia, tets);
+        m.nAristas = extraerAristasUnicas(indices).size() / 2;
+        m.msAristas = std::min(m.msAristas, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    }
+
+    std::deque<uint32_t> cache;
+    size_t aciertos = 0;
+    for (uint32_t v : indices) {
+        if (std::find(cache.begin(), cache.end(), v) != cache.end()) { ++aciertos; continue; }
+        cache.push_back(v);
+        if (cache.size() > TAM_CACHE_VERTICES) cache.pop_front();
+    }
+    m.aciertos = indices.empty() ? 0.0 : (double)aciertos / indices.size();
+    return m;
+}
+
+// ------------------------- MAIN -------------------------
+// Uso: reordenarMalla [carpeta] [--medir]
+// Reescribe cada .bin de la carpeta (por defecto "output") en orden Morton
+// e imprime la medición antes y después. Con --medir no escribe nada: mide
+// el orden actual y el que quedaría. Los archivos van de a uno para que las
+// mediciones no compitan entre sí.
+int main(int argc, char** argv) {
+    std::string carpeta = "output";
+    bool soloMedir = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--medir") soloMedir = true;
+        else carpeta = a;
+    }
+
+    std::vector<std::string> rutas;
+    for (auto& entry : std::filesystem::directory_iterator(carpeta)) {
+        if (entry.path().extension() == ".bin") rutas.push_back(entry.path().string());
+    }
+    std::sort(rutas.begin(), rutas.end());
+
+    double totalAntes = 0.0, totalDespues = 0.0;
+    std::cout << "archivo,tetraedros,aristas,ms_antes,ms_despues,cache_antes,cache_despues\n";
+    for (const auto& ruta : rutas) {
+        try {
+            std::vector<Point> points;
+            std::vector<Tetrahedron> tets;
+            leerBin(ruta, points, tets);
+
+            Medida antes = medir(points, tets);
+            reordenar(points, tets);
+            Medida despues = medir(points, tets);
+            if (despues.nAristas != antes.nAristas)
+                throw std::runtime_error("El reordenamiento cambió la malla: " + ruta);
+            if (!soloMedir) escribirBin(ruta, points, tets);
+
+            totalAntes += antes.msAristas;
+            totalDespues += despues.msAristas;
+            std::cout << std::filesystem::path(ruta).filename().string() << "," << tets.size() << "," << antes.nAristas
+                      << "," << antes.msAristas << "," << despues.msAristas
+                      << "," << antes.aciertos << "," << despues.aciertos << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+    if (!rutas.empty())
+        std::cerr << "Aristas: " << totalAntes << " ms -> " << totalDespues << " ms"
+                  << (soloMedir ? " (sin escribir)" : "") << "\n";
+    return 0;
+}
@@ -0,0 +1,453 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <queue>
+#include <tuple>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <omp.h>
+
+#include "../output/mallaComun.h"
+
+// ------------------------- PARÁMETROS -------------------------
+// Simplificación por colapso de aristas (a -> b: a desaparece y sus
+// tetraedros pasan a usar b, que no se mueve). Los niveles se escriben como
+// lod/<nombre>.lod1.bin, .lod2.bin, ... dentro de la carpeta de los .bin
+// (aparte, para que los visores y las demás herramientas, que toman todos
+// los .bin de la carpeta, no los lean como partes), cada uno con
+// FACTOR_NIVEL veces menos tetraedros que el anterior, y todos salen de la
+// misma pasada: el nivel i+1 sigue colapsando desde el nivel i.
+//
+// Costo de un colapso: si a es interior, la distancia |a - b| (lo que se
+// corre el vértice); si a está en el borde, la distancia de b a los planos
+// de las caras de borde que ya absorbió a (cuádrica de Garland-Heckbert
+// sin término de área). Un colapso se rechaza si invierte o aplana algún
+// tetraedro, duplica uno existente o cambia las caras de borde de la
+// estrella (el borde se simplifica pero no se abre ni se pliega).
+const int NIVELES_POR_DEFECTO = 3;
+const double FACTOR_NIVEL = 4.0;
+const double VOLUMEN_MIN_RELATIVO = 1e-6;   // Por el cubo de la arista media
+const double COS_MIN_NORMAL_BORDE = 0.2;    // Giro máximo de una cara de borde
+
+// ------------------------- SIMPLIFICACIÓN -------------------------
+using Cara = std::array<uint32_t, 3>;
+
+// Cara opuesta al vértice k del tetraedro, con la normal hacia el interior
+// del tetraedro (van con volumen >= 0); todas con el mismo criterio, así se
+// puede comparar la normal de una cara antes y después de un colapso
+Cara caraOrientada(const std::array<uint32_t, 4>& t, int k) {
+    static const int caras[4][3] = {{1,3,2},{0,2,3},{0,3,1},{0,1,2}};
+    return {t[caras[k][0]], t[caras[k][1]], t[caras[k][2]]};
+}
+
+Cara ordenada(Cara c) {
+    std::sort(c.begin(), c.end());
+    return c;
+}
+
+struct Cuadrica {
+    double a2 = 0, ab = 0, ac = 0, ad = 0, b2 = 0, bc = 0, bd = 0, c2 = 0, cd = 0, d2 = 0;
+
+    void sumarPlano(double a, double b, double c, double d) {
+        a2 += a * a; ab += a * b; ac += a * c; ad += a * d;
+        b2 += b * b; bc += b * c; bd += b * d;
+        c2 += c * c; cd += c * d; d2 += d * d;
+    }
+    void sumar(const Cuadrica& q) {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2;
+        bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+    }
+    // Suma de distancias al cuadrado a los planos
+    double evaluar(const Point& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+             + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+             + c2 * z * z + 2 * cd * z + d2;
+    }
+};
+
+class Simplificador {
+public:
+    Simplificador(std::vector<Point> pts, const std::vector<uint32_t>& indices) : pos(std::move(pts)) {
+        size_t nTets = indices.size() / 4;
+        tets.resize(nTets);
+        vivo.assign(nTets, 1);
+        estrella.resize(pos.size());
+        double sumaAristas = 0.0;
+        for (size_t t = 0; t < nTets; ++t) {
+            auto& tet = tets[t];
+            std::copy_n(&indices[t * 4], 4, tet.begin());
+            if (volumen(tet) < 0) std::swap(tet[2], tet[3]);
+            for (uint32_t v : tet) estrella[v].push_back(t);
+            sumaAristas += distancia(pos[tet[0]], pos[tet[1]]);
+        }
+        tetsVivos = nTets;
+        double arista = nTets ? sumaAristas / nTets : 1.0;
+        volumenMin = VOLUMEN_MIN_RELATIVO * arista * arista * arista;
+
+        // Caras de borde: las que aparecen una sola vez
+        std::vector<std::pair<Cara, Cara>> caras;
+        caras.reserve(nTets * 4);
+        for (const auto& tet : tets)
+            for (int k = 0; k < 4; ++k) {
+                Cara c = caraOrientada(tet, k);
+                caras.push_back({ordenada(c), c});
+            }
+        std::sort(caras.begin(), caras.end());
+        borde.assign(pos.size(), 0);
+        cuadricas.resize(pos.size());
+        for (size_t i = 0; i < caras.size(); ) {
+            size_t j = i;
+            while (j < caras.size() && caras[j].first == caras[i].first) ++j;
+            if (j - i == 1) {
+                const Cara& c = caras[i].second;
+                double n[3];
+                if (normal(c, n)) {
+                    double d = -(n[0] * pos[c[0]].x + n[1] * pos[c[0]].y + n[2] * pos[c[0]].z);
+                    for (uint32_t v : c) cuadricas[v].sumarPlano(n[0], n[1], n[2], d);
+                }
+                for (uint32_t v : c) borde[v] = 1;
+            }
+            i = j;
+        }
+
+        version.assign(pos.size(), 0);
+        verticeVivo.assign(pos.size(), 1);
+        for (uint32_t v = 0; v < pos.size(); ++v)
+            if (!estrella[v].empty()) encolar(v, 0);
+    }
+
+    size_t tetraedros() const { return tetsVivos; }
+
+    // Colapsa hasta quedar en `objetivo` tetraedros o hasta que el colapso
+    // más barato cueste más que `errorMax`. Devuelve el costo del último.
+    double simplificar(size_t objetivo, double errorMax) {
+        while (tetsVivos > objetivo && !cola.empty()) {
+            auto [negCosto, a, b, ver, rango] = cola.top();
+            if (-negCosto > errorMax) break;
+            cola.pop();
+            if (!verticeVivo[a] || !verticeVivo[b] || version[a] != ver) continue;
+            if (!colapsar(a, b)) { encolar(a, rango + 1); continue; }
+            ultimoCosto = -negCosto;
+        }
+        return ultimoCosto;
+    }
+
+    // Malla actual en el formato del .bin, sólo con los vértices usados
+    void exportar(std::vector<Point>& points, std::vector<Tetrahedron>& salida) const {
+        std::vector<uint32_t> nuevo(pos.size(), UINT32_MAX);
+        points.clear();
+        salida.clear();
+        salida.reserve(tetsVivos);
+        for (size_t t = 0; t < tets.size(); ++t) {
+            if (!vivo[t]) continue;
+            const auto& tet = tets[t];
+            for (uint32_t v : tet)
+                if (nuevo[v] == UINT32_MAX) { nuevo[v] = points.size(); points.push_back(pos[v]); }
+            salida.push_back({pos[tet[0]], pos[tet[1]], pos[tet[2]], pos[tet[3]]});
+        }
+    }
+
+private:
+    std::vector<Point> pos;
+    std::vector<std::array<uint32_t, 4>> tets;
+    std::vector<uint8_t> vivo;
+    std::vector<std::vector<uint32_t>> estrella;   // Tetraedros de cada vértice (puede tener muertos)
+    std::vector<uint8_t> borde, verticeVivo;
+    std::vector<Cuadrica> cuadricas;
+    std::vector<uint32_t> version;
+    // Min-heap por costo con invalidación perezosa: una entrada vale si su
+    // versión coincide con la de a, que sube cada vez que cambia su estrella.
+    // Cada vértice tiene una sola entrada viva, su vecino número `rango` en
+    // orden de costo; si ese colapso se rechaza entra el siguiente.
+    std::priority_queue<std::tuple<double, uint32_t, uint32_t, uint32_t, uint32_t>> cola;
+    size_t tetsVivos = 0;
+    double volumenMin = 0.0;
+    double ultimoCosto = 0.0;
+
+    static double distancia(const Point& a, const Point& b) {
+        return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y) + (a.z - b.z) * (a.z - b.z));
+    }
+
+    // Seis veces el volumen con signo
+    double volumen(const std::array<uint32_t, 4>& t) const {
+        const Point &a = pos[t[0]], &b = pos[t[1]], &c = pos[t[2]], &d = pos[t[3]];
+        double ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+        double vx = c.x - a.x, vy = c.y - a.y, vz = c.z - a.z;
+        double wx = d.x - a.x, wy = d.y - a.y, wz = d.z - a.z;
+        return ux * (vy * wz - vz * wy) - uy * (vx * wz - vz * wx) + uz * (vx * wy - vy * wx);
+    }
+
+    bool normal(const Cara& c, double n[3]) const {
+        const Point &a = pos[c[0]], &b = pos[c[1]], &d = pos[c[2]];
+        double ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+        double vx = d.x - a.x, vy = d.y - a.y, vz = d.z - a.z;
+        n[0] = uy * vz - uz * vy;
+        n[1] = uz * vx - ux * vz;
+        n[2] = ux * vy - uy * vx;
+        double l = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (l == 0.0) return false;
+        for (int k = 0; k < 3; ++k) n[k] /= l;
+        return true;
+    }
+
+    void limpiarEstrella(uint32_t v) {
+        auto& e = estrella[v];
+        e.erase(std::remove_if(e.begin(), e.end(), [&](uint32_t t) { return !vivo[t]; }), e.end());
+    }
+
+    double costo(uint32_t a, uint32_t b) const {
+        if (!borde[a]) return distancia(pos[a], pos[b]);
+        return std::sqrt(std::max(cuadricas[a].evaluar(pos[b]), 0.0));
+    }
+
+    // Un vértice de borde sólo puede ir a otro de borde
+    void encolar(uint32_t a, uint32_t rango) {
+        std::vector<uint32_t> vecinos;
+        for (uint32_t t : estrella[a])
+            if (vivo[t])
+                for (uint32_t v : tets[t])
+                    if (v != a && (!borde[a] || borde[v])) vecinos.push_back(v);
+        std::sort(vecinos.begin(), vecinos.end());
+        vecinos.erase(std::unique(vecinos.begin(), vecinos.end()), vecinos.end());
+        if (rango >= vecinos.size()) return;
+        std::vector<std::pair<double, uint32_t>> candidatos;
+        for (uint32_t b : vecinos) candidatos.push_back({costo(a, b), b});
+        std::nth_element(candidatos.begin(), candidatos.begin() + rango, candidatos.end());
+        cola.push({-candidatos[rango].first, a, candidatos[rango].second, version[a], rango});
+    }
+
+    // Caras de borde de la estrella de v (las que tienen a v y aparecen una vez)
+    void carasDeBorde(const std::vector<std::array<uint32_t, 4>>& estrellaTets, uint32_t v,
+                      std::vector<Cara>& unicas, bool& sobrecargada) const {
+        std::vector<std::pair<Cara, Cara>> caras;
+        for (const auto& tet : estrellaTets)
+            for (int k = 0; k < 4; ++k) {
+                if (tet[k] == v) continue;
+                Cara c = caraOrientada(tet, k);
+                caras.push_back({ordenada(c), c});
+            }
+        std::sort(caras.begin(), caras.end());
+        sobrecargada = false;
+        unicas.clear();
+        for (size_t i = 0; i < caras.size(); ) {
+            size_t j = i;
+            while (j < caras.size() && caras[j].first == caras[i].first) ++j;
+            if (j - i == 1) unicas.push_back(caras[i].second);
+            else if (j - i > 2) sobrecargada = true;
+            i = j;
+        }
+    }
+
+    // Las caras de borde alrededor de v forman un solo abanico cerrado (si no,
+    // dos partes del borde se tocan en v). Sin caras, v es interior.
+    static bool abanicoSimple(const std::vector<Cara>& caras, uint32_t v) {
+        if (caras.empty()) return true;
+        std::vector<std::pair<uint32_t, uint32_t>> lados;   // Arista opuesta a v en cada cara
+        for (const auto& c : caras) {
+            uint32_t x = UINT32_MAX, y = UINT32_MAX;
+            for (uint32_t w : c)
+                if (w != v) (x == UINT32_MAX ? x : y) = w;
+            if (y == UINT32_MAX) return false;
+            lados.push_back({x, y});
+        }
+        std::vector<uint32_t> extremos;
+        for (const auto& [x, y] : lados) { extremos.push_back(x); extremos.push_back(y); }
+        std::sort(extremos.begin(), extremos.end());
+        for (size_t i = 0; i < extremos.size(); i += 2)
+            if (i + 1 >= extremos.size() || extremos[i] != extremos[i + 1] ||
+                (i + 2 < extremos.size() && extremos[i + 2] == extremos[i])) return false;
+
+        // Cada vecino en dos lados: el abanico es una unión de ciclos; tiene que ser uno
+        std::vector<uint8_t> usado(lados.size(), 0);
+        uint32_t actual = lados[0].second;
+        usado[0] = 1;
+        for (size_t visitados = 1; visitados < lados.size(); ++visitados) {
+            size_t siguiente = lados.size();
+            for (size_t i = 0; i < lados.size() && siguiente == lados.size(); ++i)
+                if (!usado[i] && (lados[i].first == actual || lados[i].second == actual)) siguiente = i;
+            if (siguiente == lados.size()) return false;
+            usado[siguiente] = 1;
+            actual = lados[siguiente].first == actual ? lados[siguiente].second : lados[siguiente].first;
+        }
+        return true;
+    }
+
+    bool colapsar(uint32_t a, uint32_t b) {
+        limpiarEstrella(a);
+        limpiarEstrella(b);
+
+        // Estrella de b después del colapso y caras de borde que debería tener
+        std::vector<std::array<uint32_t, 4>> despues;
+        std::vector<uint32_t> quitar, cambiar;
+        for (uint32_t t : estrella[a]) {
+            const auto& tet = tets[t];
+            if (std::find(tet.begin(), tet.end(), b) != tet.end()) { quitar.push_back(t); continue; }
+            auto nuevo = tet;
+            std::replace(nuevo.begin(), nuevo.end(), a, b);
+            double v = volumen(nuevo);
+            if (v <= volumenMin) return false;                  // Invertido o aplanado
+            cambiar.push_back(t);
+            despues.push_back(nuevo);
+        }
+        if (quitar.empty()) return false;
+        for (uint32_t t : estrella[b])
+            if (std::find(quitar.begin(), quitar.end(), t) == quitar.end()) despues.push_back(tets[t]);
+
+        // Mismo borde alrededor de b: las caras únicas de la estrella nueva
+        // son las de la unión vieja (de a y de b) con a cambiado por b, y
+        // ninguna cara queda en más de dos tetraedros
+        std::vector<Cara> bordeDespues;
+        bool sobrecargada;
+        carasDeBorde(despues, b, bordeDespues, sobrecargada);
+        if (sobrecargada) return false;
+        std::vector<Cara> bordeA, bordeB;
+        {
+            std::vector<std::array<uint32_t, 4>> ea, eb;
+            for (uint32_t t : estrella[a]) ea.push_back(tets[t]);
+            for (uint32_t t : estrella[b]) eb.push_back(tets[t]);
+            carasDeBorde(ea, a, bordeA, sobrecargada);
+            carasDeBorde(eb, b, bordeB, sobrecargada);
+        }
+        std::vector<Cara> esperadas;
+        std::vector<Cara> viejas;   // Misma cara antes del colapso, para comparar normales
+        for (const auto& c : bordeA) {
+            if (std::find(c.begin(), c.end(), b) != c.end()) continue;   // Desaparece con el colapso
+            Cara n = c;
+            std::replace(n.begin(), n.end(), a, b);
+            esperadas.push_back(n);
+            viejas.push_back(c);
+        }
+        for (const auto& c : bordeB) {
+            if (std::find(c.begin(), c.end(), a) != c.end()) continue;
+            esperadas.push_back(c);
+            viejas.push_back(c);
+        }
+        if (esperadas.size() != bordeDespues.size()) return false;
+        std::vector<Cara> e1 = esperadas, e2 = bordeDespues;
+        for (auto& c : e1) c = ordenada(c);
+        for (auto& c : e2) c = ordenada(c);
+        std::sort(e1.begin(), e1.end());
+        std::sort(e2.begin(), e2.end());
+        if (e1 != e2 || std::adjacent_find(e1.begin(), e1.end()) != e1.end()) return false;
+        if (!abanicoSimple(bordeDespues, b)) return false;
+        for (size_t i = 0; i < esperadas.size(); ++i) {
+            double n0[3], n1[3];
+            if (!normal(esperadas[i], n1)) return false;
+            if (normal(viejas[i], n0) && n0[0] * n1[0] + n0[1] * n1[1] + n0[2] * n1[2] < COS_MIN_NORMAL_BORDE)
+                return false;
+        }
+
+        // Sin tetraedros repetidos alrededor de b
+        std::vector<std::array<uint32_t, 4>> claves;
+        for (const auto& tet : despues) {
+            auto k = tet;
+            std::sort(k.begin(), k.end());
+            claves.push_back(k);
+        }
+        std::sort(claves.begin(), claves.end());
+        if (std::adjacent_find(claves.begin(), claves.end()) != claves.end()) return false;
+
+        // Aplicar
+        for (uint32_t t : quitar) vivo[t] = 0;
+        tetsVivos -= quitar.size();
+        for (uint32_t t : cambiar) {
+            std::replace(tets[t].begin(), tets[t].end(), a, b);
+            estrella[b].push_back(t);
+        }
+        estrella[a].clear();
+        verticeVivo[a] = 0;
+        if (borde[a]) cuadricas[b].sumar(cuadricas[a]);
+        limpiarEstrella(b);
+
+        std::vector<uint32_t> afectados;
+        for (uint32_t t : estrella[b])
+            for (uint32_t v : tets[t]) afectados.push_back(v);
+        std::sort(afectados.begin(), afectados.end());
+        afectados.erase(std::unique(afectados.begin(), afectados.end()), afectados.end());
+        for (uint32_t v : afectados) {
+            ++version[v];
+            encolar(v, 0);
+        }
+        return true;
+    }
+};
+
+// ------------------------- MAIN -------------------------
+// Uso: simplificarMalla [carpeta] [--niveles L] [--tets N] [--error e]
+// Por cada .bin de la carpeta (por defecto "output") escribe L niveles en lod/
+// (por defecto 3). Sin --tets el nivel i apunta a N0 / FACTOR_NIVEL^i
+// tetraedros; con --tets el último apunta a N y los intermedios quedan en
+// progresión geométrica. --error corta cualquier nivel en cuanto el colapso
+// más barato supera e (en unidades del .bin, que está en [-1, 1]); los
+// niveles que ya no bajan no se escriben.
+int main(int argc, char** argv) {
+    std::string carpeta = "output";
+    int niveles = NIVELES_POR_DEFECTO;
+    size_t tetsFinal = 0;
+    double errorMax = INFINITY;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--niveles" && i + 1 < argc) niveles = std::max(1, std::stoi(argv[++i]));
+        else if (a == "--tets" && i + 1 < argc) tetsFinal = std::stoull(argv[++i]);
+        else if (a == "--error" && i + 1 < argc) errorMax = std::stod(argv[++i]);
+        else carpeta = a;
+    }
+
+    std::vector<std::string> rutas;
+    for (auto& entry : std::filesystem::directory_iterator(carpeta)) {
+        if (entry.path().extension() == ".bin") rutas.push_back(entry.path().string());
+    }
+    std::sort(rutas.begin(), rutas.end());
+    const std::filesystem::path carpetaNiveles = std::filesystem::path(carpeta) / "lod";
+    std::filesystem::create_directories(carpetaNiveles);
+
+    std::cout << "archivo,nivel,tetraedros,puntos,costo_max,ms\n";
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < rutas.size(); ++i) {
+        try {
+            auto t0 = std::chrono::steady_clock::now();
+            std::vector<Point> points;
+            std::vector<Tetrahedron> tets;
+            leerBin(rutas[i], points, tets);
+            std::vector<uint32_t> indices = indexarTetraedros(points, tets);
+            size_t n0 = tets.size();
+            tets.clear();
+            tets.shrink_to_fit();
+            Simplificador s(std::move(points), indices);
+
+            double razon = tetsFinal > 0 ? std::pow((double)tetsFinal / std::max<size_t>(n0, 1), 1.0 / niveles)
+                                         : 1.0 / FACTOR_NIVEL;
+            size_t anterior = n0;
+            for (int nivel = 1; nivel <= niveles; ++nivel) {
+                size_t objetivo = (size_t)std::llround(n0 * std::pow(razon, nivel));
+                double costo = s.simplificar(objetivo, errorMax);
+                if (s.tetraedros() >= anterior) break;
+                anterior = s.tetraedros();
+
+                std::vector<Point> pts;
+                std::vector<Tetrahedron> salida;
+                s.exportar(pts, salida);
+                std::string nombreNivel = std::filesystem::path(rutas[i]).stem().string() + ".lod" + std::to_string(nivel) + ".bin";
+                std::string rutaNivel = (carpetaNiveles / nombreNivel).string();
+                escribirBin(rutaNivel, pts, salida);
+
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                #pragma omp critical
+                std::cout << std::filesystem::path(rutaNivel).filename().string() << "," << nivel << ","
+                          << salida.size() << "," << pts.size() << "," << costo << "," << ms << "\n";
+            }
+        } catch (const std::exception& e) {
+            #pragma omp critical
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,312 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <omp.h>
+#include <opencv2/opencv.hpp>
+
+#include "../output/mallaComun.h"
+
+// ------------------------- PARÁMETROS -------------------------
+// Superficie de cada máscara de imagenT/ por surface nets: un vértice por
+// celda de 2x2x2 vóxeles con esquinas dentro y fuera (en el promedio de
+// los cruces de sus aristas) y un cuadrilátero por cada arista de la
+// grilla que cruza el borde, con los vértices de las cuatro celdas que la
+// rodean. Como cada celda tiene un solo vértice, los cuadriláteros vecinos
+// ya lo comparten: la malla sale soldada sin buscar duplicados.
+//
+// Sale en el mismo .qbin que lee el visor (ver test/compactarMalla.cpp):
+// puntos cuantizados en orden Morton y las aristas únicas de los
+// cuadriláteros. Después de las aristas va un bloque opcional con los
+// triángulos (dos por cuadrilátero), que los lectores de .qbin ignoran:
+//   MAGIA_TRIANGULOS, nTriangulos (uint32), nTriangulos * 3 uint32.
+// Las coordenadas van normalizadas a [-1, 1] con la caja del volumen
+// (x = columna, y = fila, z = capa), igual para todos los órganos.
+const double MAX_CUANTIZADO = 65535.0;
+
+// ------------------------- VOLUMEN -------------------------
+struct Volumen {
+    int ancho = 0, alto = 0, capas = 0;
+    std::vector<uint8_t> datos;   // 1 dentro, 0 fuera; x varía más rápido
+
+    // Fuera del volumen es fuera de la máscara: la superficie queda cerrada
+    uint8_t en(int x, int y, int z) const {
+        if (x < 0 || y < 0 || z < 0 || x >= ancho || y >= alto || z >= capas) return 0;
+        return datos[((size_t)z * alto + y) * ancho + x];
+    }
+};
+
+// Cualquier valor no nulo es máscara, sin importar la profundidad del TIFF
+Volumen leerVolumen(const std::string& ruta) {
+    std::vector<cv::Mat> paginas;
+    if (!cv::imreadmulti(ruta, paginas, cv::IMREAD_UNCHANGED) || paginas.empty())
+        throw std::runtime_error("No se pudo leer: " + ruta);
+
+    Volumen v;
+    v.ancho = paginas[0].cols;
+    v.alto = paginas[0].rows;
+    v.capas = paginas.size();
+    v.datos.assign((size_t)v.ancho * v.alto * v.capas, 0);
+    #pragma omp parallel for
+    for (int z = 0; z < v.capas; ++z) {
+        cv::Mat p = paginas[z];
+        if (p.cols != v.ancho || p.rows != v.alto) continue;
+        if (p.channels() > 1) cv::cvtColor(p, p, cv::COLOR_BGR2GRAY);
+        cv::Mat binaria;
+        cv::compare(p, 0, binaria, cv::CMP_GT);
+        for (int y = 0; y < v.alto; ++y) {
+            const uchar* fila = binaria.ptr<uchar>(y);
+            uint8_t* destino = &v.datos[((size_t)z * v.alto + y) * v.ancho];
+            for (int x = 0; x < v.ancho; ++x) destino[x] = fila[x] ? 1 : 0;
+        }
+    }
+    return v;
+}
+
+// ------------------------- SURFACE NETS -------------------------
+// La celda (cx, cy, cz) tiene esquinas de (cx, cy, cz) a (cx+1, cy+1, cz+1)
+// y va de -1 a dim-1 en cada eje, para cerrar la superficie en el borde
+// del volumen. Cada capa de celdas guarda sus celdas activas en orden de
+// fila, así que se buscan por clave con búsqueda binaria.
+struct CeldaActiva {
+    uint32_t clave;     // (cy + 1) * (ancho + 1) + (cx + 1)
+    float pos[3];
+};
+
+struct Malla {
+    std::vector<float> vertices;        // x, y, z en coordenadas de vóxel
+    std::vector<uint32_t> cuadrilateros; // 4 por cuadrilátero
+};
+
+Malla surfaceNets(const Volumen& v) {
+    const int nx = v.ancho + 1, ny = v.alto + 1, nz = v.capas + 1;   // Celdas por eje
+    std::vector<std::vector<CeldaActiva>> activas(nz);
+    static const int esquinas[8][3] = {{0,0,0},{1,0,0},{0,1,0},{1,1,0},{0,0,1},{1,0,1},{0,1,1},{1,1,1}};
+    static const int aristasCelda[12][2] = {{0,1},{2,3},{4,5},{6,7},{0,2},{1,3},{4,6},{5,7},{0,4},{1,5},{2,6},{3,7}};
+
+    // Filas (y, z) con algún vóxel: las celdas cuyas cuatro filas están
+    // vacías se saltean enteras, que en un órgano son casi todas
+    std::vector<uint8_t> filaOcupada((size_t)v.alto * v.capas, 0);
+    #pragma omp parallel for
+    for (int z = 0; z < v.capas; ++z)
+        for (int y = 0; y < v.alto; ++y) {
+            const uint8_t* f = &v.datos[((size_t)z * v.alto + y) * v.ancho];
+            filaOcupada[(size_t)z * v.alto + y] = std::find(f, f + v.ancho, 1) != f + v.ancho;
+        }
+    auto fila = [&](int y, int z) -> const uint8_t* {
+        if (y < 0 || z < 0 || y >= v.alto || z >= v.capas || !filaOcupada[(size_t)z * v.alto + y]) return nullptr;
+        return &v.datos[((size_t)z * v.alto + y) * v.ancho];
+    };
+
+    // 1. Celdas activas y su vértice, por capa. El código de la celda junta
+    // dos columnas de cuatro vóxeles (bit e = esquina e), la de x y la de x+1.
+    #pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < nz; ++k) {
+        int cz = k - 1;
+        for (int j = 0; j < ny; ++j) {
+            int cy = j - 1;
+            const uint8_t* filas[4] = {fila(cy, cz), fila(cy + 1, cz), fila(cy, cz + 1), fila(cy + 1, cz + 1)};
+            if (!filas[0] && !filas[1] && !filas[2] && !filas[3]) continue;
+            auto columna = [&](int x) {
+                if (x < 0 || x >= v.ancho) return 0;
+                int c = 0;
+                for (int r = 0; r < 4; ++r)
+                    if (filas[r]) c |= filas[r][x] << (r * 2);
+                return c;
+            };
+            int izquierda = columna(-1);
+            for (int i = 0; i < nx; ++i) {
+                int cx = i - 1;
+                int derecha = columna(cx + 1);
+                int codigo = izquierda | (derecha << 1);
+                izquierda = derecha;
+                if (codigo == 0 || codigo == 255) continue;
+
+                float suma[3] = {0, 0, 0};
+                int cruces = 0;
+                for (const auto& a : aristasCelda) {
+                    if (((codigo >> a[0]) & 1) == ((codigo >> a[1]) & 1)) continue;
+                    for (int d = 0; d < 3; ++d) suma[d] += (esquinas[a[0]][d] + esquinas[a[1]][d]) * 0.5f;
+                    ++cruces;
+                }
+                activas[k].push_back({(uint32_t)(j * nx + i),
+                                      {cx + suma[0] / cruces, cy + suma[1] / cruces, cz + suma[2] / cruces}});
+            }
+        }
+    }
+
+    // 2. Índices globales: prefijo por capa
+    std::vector<size_t> primero(nz + 1, 0);
+    for (int k = 0; k < nz; ++k) primero[k + 1] = primero[k] + activas[k].size();
+    Malla m;
+    m.vertices.resize(primero[nz] * 3);
+    #pragma omp parallel for
+    for (int k = 0; k < nz; ++k)
+        for (size_t c = 0; c < activas[k].size(); ++c)
+            std::copy_n(activas[k][c].pos, 3, &m.vertices[(primero[k] + c) * 3]);
+
+    auto indice = [&](int k, int j, int i) -> uint32_t {
+        const auto& capa = activas[k];
+        uint32_t clave = j * nx + i;
+        auto it = std::lower_bound(capa.begin(), capa.end(), clave,
+                                   [](const CeldaActiva& c, uint32_t v) { return c.clave < v; });
+        return (uint32_t)(primero[k] + (it - capa.begin()));
+    };
+
+    // 3. Un cuadrilátero por arista que cruza: la arista que sale de la
+    // esquina mínima de cada celda activa hacia +x, +y, +z, con las cuatro
+    // celdas que la comparten, orientado con la normal hacia afuera.
+    std::vector<std::vector<uint32_t>> porCapa(nz);
+    #pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < nz; ++k) {
+        auto& out = porCapa[k];
+        for (const auto& c : activas[k]) {
+            int j = c.clave / nx, i = c.clave % nx;
+            int x = i - 1, y = j - 1, z = k - 1;
+            uint8_t v0 = v.en(x, y, z);
+            for (int eje = 0; eje < 3; ++eje) {
+                uint8_t v1 = v.en(x + (eje == 0), y + (eje == 1), z + (eje == 2));
+                if (v0 == v1) continue;
+                // Un cruce siempre tiene las cuatro celdas; esto solo protege el borde
+                if (eje == 0 && (j == 0 || k == 0)) continue;
+                if (eje == 1 && (i == 0 || k == 0)) continue;
+                if (eje == 2 && (i == 0 || j == 0)) continue;
+                uint32_t q[4];
+                if (eje == 0) q[0] = indice(k, j, i), q[1] = indice(k, j - 1, i), q[2] = indice(k - 1, j - 1, i), q[3] = indice(k - 1, j, i);
+                else if (eje == 1) q[0] = indice(k, j, i), q[1] = indice(k - 1, j, i), q[2] = indice(k - 1, j, i - 1), q[3] = indice(k, j, i - 1);
+                else q[0] = indice(k, j, i), q[1] = indice(k, j, i - 1), q[2] = indice(k, j - 1, i - 1), q[3] = indice(k, j - 1, i);
+                if (!v0) std::swap(q[1], q[3]);
+                out.insert(out.end(), q, q + 4);
+            }
+        }
+    }
+    for (const auto& q : porCapa) m.cuadrilateros.insert(m.cuadrilateros.end(), q.begin(), q.end());
+    return m;
+}
+
+// ------------------------- ESCRITURA -------------------------
+// Devuelve el tamaño en bytes del archivo escrito
+size_t escribirSuperficie(const std::string& ruta, const Malla& m, const Volumen& v) {
+    size_t n = m.vertices.size() / 3;
+    if (n > UINT32_MAX) throw std::runtime_error("Demasiados vértices: " + ruta);
+
+    // Normalizado con la caja del volumen; la caja del .qbin es la de los puntos
+    const double dims[3] = {(double)v.ancho, (double)v.alto, (double)v.capas};
+    float mn[3] = {1e30f, 1e30f, 1e30f}, mx[3] = {-1e30f, -1e30f, -1e30f};
+    std::vector<double> normalizados(n * 3);
+    for (size_t i = 0; i < n * 3; ++i) {
+        int k = i % 3;
+        normalizados[i] = dims[k] > 1 ? m.vertices[i] / (dims[k] - 1) * 2.0 - 1.0 : 0.0;
+        mn[k] = std::min(mn[k], (float)normalizados[i]);
+        mx[k] = std::max(mx[k], (float)normalizados[i]);
+    }
+    std::vector<uint16_t> q(n * 3);
+    for (size_t i = 0; i < n * 3; ++i) {
+        int k = i % 3;
+        double ext = std::max((double)mx[k] - mn[k], 1e-12);
+        q[i] = (uint16_t)std::lround(std::min(std::max((normalizados[i] - mn[k]) / ext, 0.0), 1.0) * MAX_CUANTIZADO);
+    }
+
+    // Orden Morton sobre los puntos cuantizados, igual que en compactarMalla
+    std::vector<std::pair<uint32_t, uint32_t>> codigos(n);
+    for (size_t i = 0; i < n; ++i)
+        codigos[i] = {(expandirBits(q[i * 3] >> 6) << 2) | (expandirBits(q[i * 3 + 1] >> 6) << 1) |
+                      expandirBits(q[i * 3 + 2] >> 6), (uint32_t)i};
+    std::sort(codigos.begin(), codigos.end());
+    std::vector<uint16_t> ordenados(q.size());
+    std::vector<uint32_t> nuevoIndice(n);
+    for (size_t i = 0; i < n; ++i) {
+        std::copy_n(&q[codigos[i].second * 3], 3, &ordenados[i * 3]);
+        nuevoIndice[codigos[i].second] = i;
+    }
+
+    // Aristas de los cuadriláteros (sin la diagonal) y dos triángulos por cada uno
+    std::vector<std::pair<uint32_t, uint32_t>> aristas;
+    std::vector<uint32_t> triangulos;
+    aristas.reserve(m.cuadrilateros.size());
+    triangulos.reserve(m.cuadrilateros.size() / 4 * 6);
+    for (size_t c = 0; c < m.cuadrilateros.size(); c += 4) {
+        uint32_t w[4];
+        for (int k = 0; k < 4; ++k) w[k] = nuevoIndice[m.cuadrilateros[c + k]];
+        for (int k = 0; k < 4; ++k) aristas.push_back({std::min(w[k], w[(k + 1) % 4]), std::max(w[k], w[(k + 1) % 4])});
+        triangulos.insert(triangulos.end(), {w[0], w[1], w[2], w[0], w[2], w[3]});
+    }
+    std::sort(aristas.begin(), aristas.end());
+    aristas.erase(std::unique(aristas.begin(), aristas.end()), aristas.end());
+
+    std::vector<uint8_t> flujo = codificarAristas(aristas);
+
+    std::ofstream out(ruta, std::ios::binary);
+    if (!out) throw std::runtime_error("No se pudo escribir: " + ruta);
+    uint32_t nPuntos = n, nAristas = aristas.size(), nTriangulos = triangulos.size() / 3;
+    uint64_t bytesAristas = flujo.size();
+    out.write(MAGIA_COMPACTO, sizeof(MAGIA_COMPACTO));
+    out.write(reinterpret_cast<const char*>(&nPuntos), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&nAristas), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(mn), sizeof(mn));
+    out.write(reinterpret_cast<const char*>(mx), sizeof(mx));
+    out.write(reinterpret_cast<const char*>(ordenados.data()), ordenados.size() * sizeof(uint16_t));
+    out.write(reinterpret_cast<const char*>(&bytesAristas), sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(flujo.data()), flujo.size());
+    out.write(MAGIA_TRIANGULOS, sizeof(MAGIA_TRIANGULOS));
+    out.write(reinterpret_cast<const char*>(&nTriangulos), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(triangulos.data()), triangulos.size() * sizeof(uint32_t));
+    if (!out) throw std::runtime_error("Error escribiendo: " + ruta);
+    return (size_t)out.tellp();
+}
+
+// ------------------------- MAIN -------------------------
+// Uso: superficieMascaras [carpetaTiff] [carpetaSalida]
+// (por defecto "imagenT" y "output/superficies"). Escribe <órgano>.qbin por
+// cada .tiff; el visor los carga con viTeta --superficies. Los órganos van
+// de a uno y el paralelismo está dentro de cada etapa (capas del volumen).
+int main(int argc, char** argv) {
+    std::string carpeta = argc > 1 ? argv[1] : "imagenT";
+    std::string salida = argc > 2 ? argv[2] : "output/superficies";
+    std::filesystem::create_directories(salida);
+
+    std::vector<std::string> rutas;
+    for (auto& entry : std::filesystem::directory_iterator(carpeta)) {
+        auto ext = entry.path().extension();
+        if (ext == ".tiff" || ext == ".tif") rutas.push_back(entry.path().string());
+    }
+    std::sort(rutas.begin(), rutas.end());
+
+    std::cout << "organo,voxeles,vertices,triangulos,kb,ms_lectura,ms_superficie,ms_escritura\n";
+    auto t0 = std::chrono::steady_clock::now();
+    for (const auto& ruta : rutas) {
+        try {
+            auto t = std::chrono::steady_clock::now();
+            auto ms = [&t]() {
+                auto ahora = std::chrono::steady_clock::now();
+                double r = std::chrono::duration<double, std::milli>(ahora - t).count();
+                t = ahora;
+                return r;
+            };
+            Volumen v = leerVolumen(ruta);
+            double msLectura = ms();
+            Malla m = surfaceNets(v);
+            double msSuperficie = ms();
+            std::string organo = std::filesystem::path(ruta).stem().string();
+            size_t bytes = escribirSuperficie(salida + "/" + organo + ".qbin", m, v);
+            double msEscritura = ms();
+
+            std::cout << organo << "," << v.datos.size() << "," << m.vertices.size() / 3 << ","
+                      << m.cuadrilateros.size() / 2 << "," << bytes / 1024 << "," << msLectura << ","
+                      << msSuperficie << "," << msEscritura << "\n";
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+    std::cerr << rutas.size() << " superficies en "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() << " ms ("
+              << omp_get_max_threads() << " hilos)\n";
+    return 0;
+}
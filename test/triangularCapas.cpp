@@ -0,0 +1,318 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <filesystem>
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <omp.h>
+#include <opencv2/opencv.hpp>
+
+// ------------------------- ESTRUCTURAS BÁSICAS -------------------------
+struct Point2 {
+    double x, y;
+    bool operator<(const Point2& other) const { return std::tie(x, y) < std::tie(other.x, other.y); }
+    bool operator==(const Point2& other) const { return x == other.x && y == other.y; }
+};
+
+struct Triangle { Point2 p1, p2, p3; };
+
+// ------------------------- PARÁMETROS -------------------------
+// De cada capa de la máscara entran los píxeles del borde (no nulos con
+// algún vecino nulo) y los del interior sobre una grilla de PASO_INTERIOR.
+//
+// Formato .capas (little endian), uno por órgano:
+//   magia, ancho, alto y nCapas (uint32), y por capa:
+//   nPuntos, nTriangulos (uint32), nPuntos * 2 uint16 (x, y en píxeles) y
+//   nTriangulos * 3 uint32 (índices en los puntos de la capa, antihorario).
+const int PASO_INTERIOR = 4;
+const char MAGIA_CAPAS[4] = {'C', 'A', 'P', '1'};
+
+// ------------------------- DELAUNAY 2D -------------------------
+// Misma estructura que Delaunay3D en kdSinstacing.cpp: los elementos se
+// guardan con sus coordenadas, cada uno con su circunferencia en caché, y
+// al insertar un punto las aristas de los triángulos malos se ordenan por
+// clave: las que aparecen una sola vez son el borde de la cavidad. Los
+// puntos entran ordenados por x, así que un triángulo cuya circunferencia
+// quedó entera a la izquierda del punto actual ya no puede volver a ser
+// malo y pasa a `cerrados`; la búsqueda sólo recorre los activos.
+class Delaunay2D {
+private:
+    struct Circunferencia { double cx, cy, r2; };
+    struct Arista {
+        std::array<Point2, 2> clave;   // Extremos ordenados
+        std::array<Point2, 2> arista;  // Como vienen en el triángulo
+    };
+
+    std::vector<Triangle> activos, cerrados;
+    std::vector<Circunferencia> circleCache;   // Paralela a `activos`
+    std::vector<Arista> aristas;               // Memoria de trabajo por punto
+    Point2 super_vertices[3];
+    const double eps = 1e-12;                  // Relativo al radio: cocirculares no cuentan
+
+    void create_super_triangle(const std::vector<Point2>& points) {
+        double minX = points[0].x, maxX = minX, minY = points[0].y, maxY = minY;
+        for (const auto& p : points) {
+            minX = std::min(minX, p.x); maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y); maxY = std::max(maxY, p.y);
+        }
+        double m = std::max({maxX - minX, maxY - minY, 1.0}) * 100.0;
+        double cx = (minX + maxX) / 2.0, cy = (minY + maxY) / 2.0;
+        super_vertices[0] = {cx - 2.0 * m, cy - m};
+        super_vertices[1] = {cx + 2.0 * m, cy - m};
+        super_vertices[2] = {cx, cy + 2.0 * m};
+        agregar({super_vertices[0], super_vertices[1], super_vertices[2]});
+    }
+
+    // Relativa a p1 para no perder precisión con coordenadas grandes
+    static Circunferencia circumcircle(const Triangle& t) {
+        double bx = t.p2.x - t.p1.x, by = t.p2.y - t.p1.y;
+        double cx = t.p3.x - t.p1.x, cy = t.p3.y - t.p1.y;
+        double d = 2.0 * (bx * cy - by * cx);
+        if (d == 0.0) return {t.p1.x, t.p1.y, std::numeric_limits<double>::infinity()};
+        double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+        double ux = (cy * b2 - by * c2) / d, uy = (bx * c2 - cx * b2) / d;
+        return {t.p1.x + ux, t.p1.y + uy, ux * ux + uy * uy};
+    }
+
+    static double orientacion(const Point2& a, const Point2& b, const Point2& c) {
+        return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+    }
+
+    void agregar(Triangle t) {
+        if (orientacion(t.p1, t.p2, t.p3) < 0) std::swap(t.p2, t.p3);
+        activos.push_back(t);
+        circleCache.push_back(circumcircle(t));
+    }
+
+    void insertarPunto(const Point2& p) {
+        // 1. Triángulos malos (sus aristas van a la memoria de trabajo) y
+        // cerrados, compactando `activos` en el mismo recorrido
+        aristas.clear();
+        size_t escritura = 0;
+        for (size_t i = 0; i < activos.size(); ++i) {
+            const Circunferencia& c = circleCache[i];
+            double dx = p.x - c.cx, dy = p.y - c.cy;
+            if (dx > 0.0 && dx * dx > c.r2) {
+                cerrados.push_back(activos[i]);
+                continue;
+            }
+            if (dx * dx + dy * dy < c.r2 * (1.0 - eps)) {
+                const Triangle& t = activos[i];
+                const std::array<Point2, 2> lados[3] = {{t.p1, t.p2}, {t.p2, t.p3}, {t.p3, t.p1}};
+                for (const auto& l : lados) {
+                    Arista a{l, l};
+                    if (a.clave[1] < a.clave[0]) std::swap(a.clave[0], a.clave[1]);
+                    aristas.push_back(a);
+                }
+                continue;
+            }
+            if (escritura != i) {
+                activos[escritura] = activos[i];
+                circleCache[escritura] = circleCache[i];
+            }
+            ++escritura;
+        }
+        activos.resize(escritura);
+        circleCache.resize(escritura);
+
+        // 2. Las aristas que aparecen una sola vez forman el borde de la cavidad
+        std::sort(aristas.begin(), aristas.end(), [](const Arista& a, const Arista& b) { return a.clave < b.clave; });
+        for (size_t i = 0; i < aristas.size();) {
+            size_t j = i + 1;
+            while (j < aristas.size() && aristas[j].clave == aristas[i].clave) ++j;
+            if (j - i == 1) agregar({aristas[i].arista[0], aristas[i].arista[1], p});
+            i = j;
+        }
+    }
+
+    bool touches_super_triangle(const Triangle& t) const {
+        for (const auto& sv : super_vertices) {
+            if (t.p1 == sv || t.p2 == sv || t.p3 == sv) return true;
+        }
+        return false;
+    }
+
+public:
+    // Los puntos se ordenan y se descartan los repetidos
+    explicit Delaunay2D(std::vector<Point2> points) {
+        if (points.empty()) return;
+        std::sort(points.begin(), points.end());
+        points.erase(std::unique(points.begin(), points.end()), points.end());
+        create_super_triangle(points);
+        for (const auto& p : points) insertarPunto(p);
+    }
+
+    std::vector<Triangle> get_triangles() const {
+        std::vector<Triangle> r;
+        r.reserve(activos.size() + cerrados.size());
+        for (const auto* v : {&cerrados, &activos})
+            for (const auto& t : *v)
+                if (!touches_super_triangle(t)) r.push_back(t);
+        return r;
+    }
+};
+
+// ------------------------- CAPAS -------------------------
+struct MallaCapa {
+    std::vector<uint16_t> puntos;      // x, y
+    std::vector<uint32_t> triangulos;  // 3 por triángulo
+    bool completa = true;              // Cumple T = 2n - 2 - h
+};
+
+std::vector<Point2> puntosDeCapa(const cv::Mat& mascara) {
+    std::vector<Point2> pts;
+    for (int y = 0; y < mascara.rows; ++y) {
+        const uchar* fila = mascara.ptr<uchar>(y);
+        const uchar* arriba = y > 0 ? mascara.ptr<uchar>(y - 1) : nullptr;
+        const uchar* abajo = y + 1 < mascara.rows ? mascara.ptr<uchar>(y + 1) : nullptr;
+        for (int x = 0; x < mascara.cols; ++x) {
+            if (!fila[x]) continue;
+            bool borde = !arriba || !abajo || x == 0 || x + 1 == mascara.cols ||
+                         !arriba[x] || !abajo[x] || !fila[x - 1] || !fila[x + 1];
+            if (borde || (x % PASO_INTERIOR == 0 && y % PASO_INTERIOR == 0))
+                pts.push_back({(double)x, (double)y});
+        }
+    }
+    return pts;
+}
+
+MallaCapa triangularCapa(const cv::Mat& mascara) {
+    MallaCapa m;
+    std::vector<Point2> pts = puntosDeCapa(mascara);
+    if (pts.size() < 3) return m;
+    std::vector<Triangle> tris = Delaunay2D(pts).get_triangles();
+
+    std::sort(pts.begin(), pts.end());
+    m.puntos.reserve(pts.size() * 2);
+    for (const auto& p : pts) m.puntos.insert(m.puntos.end(), {(uint16_t)p.x, (uint16_t)p.y});
+    auto indice = [&](const Point2& p) { return (uint32_t)(std::lower_bound(pts.begin(), pts.end(), p) - pts.begin()); };
+
+    std::vector<uint64_t> lados;
+    m.triangulos.reserve(tris.size() * 3);
+    for (const auto& t : tris) {
+        uint32_t v[3] = {indice(t.p1), indice(t.p2), indice(t.p3)};
+        m.triangulos.insert(m.triangulos.end(), v, v + 3);
+        for (int k = 0; k < 3; ++k) {
+            uint64_t a = v[k], b = v[(k + 1) % 3];
+            lados.push_back((std::min(a, b) << 32) | std::max(a, b));
+        }
+    }
+
+    // Control de calidad: con h aristas de borde, una triangulación de la
+    // cápsula convexa de n puntos tiene 2n - 2 - h triángulos
+    std::sort(lados.begin(), lados.end());
+    size_t borde = 0;
+    for (size_t i = 0; i < lados.size();) {
+        size_t j = i + 1;
+        while (j < lados.size() && lados[j] == lados[i]) ++j;
+        if (j - i == 1) ++borde;
+        i = j;
+    }
+    m.completa = tris.size() == 2 * pts.size() - 2 - borde;
+    return m;
+}
+
+// Cualquier valor no nulo es máscara, sin importar la profundidad del TIFF
+std::vector<cv::Mat> leerCapas(const std::string& ruta) {
+    std::vector<cv::Mat> paginas;
+    if (!cv::imreadmulti(ruta, paginas, cv::IMREAD_UNCHANGED))
+        throw std::runtime_error("No se pudo leer: " + ruta);
+    for (auto& p : paginas) {
+        if (p.channels() > 1) cv::cvtColor(p, p, cv::COLOR_BGR2GRAY);
+        cv::Mat binaria;
+        cv::compare(p, 0, binaria, cv::CMP_GT);
+        p = binaria;
+    }
+    return paginas;
+}
+
+void escribirCapas(const std::string& ruta, const std::vector<cv::Mat>& capas, const std::vector<MallaCapa>& mallas) {
+    std::ofstream out(ruta, std::ios::binary);
+    if (!out) throw std::runtime_error("No se pudo escribir: " + ruta);
+    uint32_t ancho = capas.empty() ? 0 : capas[0].cols, alto = capas.empty() ? 0 : capas[0].rows;
+    uint32_t nCapas = mallas.size();
+    out.write(MAGIA_CAPAS, sizeof(MAGIA_CAPAS));
+    out.write(reinterpret_cast<const char*>(&ancho), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&alto), sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&nCapas), sizeof(uint32_t));
+    for (const auto& m : mallas) {
+        uint32_t nPuntos = m.puntos.size() / 2, nTriangulos = m.triangulos.size() / 3;
+        out.write(reinterpret_cast<const char*>(&nPuntos), sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(&nTriangulos), sizeof(uint32_t));
+        out.write(reinterpret_cast<const char*>(m.puntos.data()), m.puntos.size() * sizeof(uint16_t));
+        out.write(reinterpret_cast<const char*>(m.triangulos.data()), m.triangulos.size() * sizeof(uint32_t));
+    }
+    if (!out) throw std::runtime_error("Error escribiendo: " + ruta);
+}
+
+// ------------------------- MAIN -------------------------
+// Uso: triangularCapas [carpetaTiff] [carpetaSalida]
+// (por defecto "imagenT" y "output/capas"). Escribe <órgano>.capas por
+// cada .tiff. Todas las capas de todos los órganos van a una misma cola de
+// tareas, una capa por tarea, para que un órgano con muchas capas no deje
+// hilos sin trabajo.
+int main(int argc, char** argv) {
+    std::string carpeta = argc > 1 ? argv[1] : "imagenT";
+    std::string salida = argc > 2 ? argv[2] : "output/capas";
+    std::filesystem::create_directories(salida);
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::vector<std::string> rutas;
+    for (auto& entry : std::filesystem::directory_iterator(carpeta)) {
+        auto ext = entry.path().extension();
+        if (ext == ".tiff" || ext == ".tif") rutas.push_back(entry.path().string());
+    }
+    std::sort(rutas.begin(), rutas.end());
+
+    std::vector<std::vector<cv::Mat>> capas(rutas.size());
+    std::vector<std::vector<MallaCapa>> mallas(rutas.size());
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t o = 0; o < rutas.size(); ++o) {
+        try {
+            capas[o] = leerCapas(rutas[o]);
+            mallas[o].resize(capas[o].size());
+        } catch (const std::exception& e) {
+            #pragma omp critical
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+    }
+
+    std::vector<std::pair<size_t, size_t>> tareas;
+    for (size_t o = 0; o < rutas.size(); ++o)
+        for (size_t z = 0; z < capas[o].size(); ++z) tareas.emplace_back(o, z);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < tareas.size(); ++i) {
+        auto [o, z] = tareas[i];
+        mallas[o][z] = triangularCapa(capas[o][z]);
+    }
+    double msTriangular = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "organo,capas,puntos,triangulos,capas_incompletas\n";
+    for (size_t o = 0; o < rutas.size(); ++o) {
+        if (capas[o].empty()) continue;
+        std::string organo = std::filesystem::path(rutas[o]).stem().string();
+        size_t puntos = 0, triangulos = 0, incompletas = 0;
+        for (const auto& m : mallas[o]) {
+            puntos += m.puntos.size() / 2;
+            triangulos += m.triangulos.size() / 3;
+            if (!m.completa) ++incompletas;
+        }
+        try {
+            escribirCapas(salida + "/" + organo + ".capas", capas[o], mallas[o]);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+        }
+        std::cout << organo << "," << capas[o].size() << "," << puntos << "," << triangulos << "," << incompletas << "\n";
+    }
+    std::cerr << tareas.size() << " capas de " << rutas.size() << " órganos en " << msTriangular << " ms ("
+              << omp_get_max_threads() << " hilos)\n";
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <omp.h>
+
+#include "../output/mallaComun.h"
+#include "../output/localizador.h"
+
+// ------------------------- PARÁMETROS -------------------------
+// Compara las consultas de KDTree (knn, radius, knnLote, radiusLote) y de
+// KDTreeDinamico (knn, radius, findNearest entre inserciones y borrados)
+// contra una búsqueda lineal. Los puntos son al azar en [-1, 1]^3 con una
+// parte repetida, y las consultas incluyen puntos del conjunto, puntos al
+// azar y puntos fuera de la caja. Con puntos a la misma distancia el orden
+// de knn no está definido, así que se comparan las distancias y que cada
+// índice devuelto esté a la distancia que dice.
+const size_t TAMANOS[] = {0, 1, 7, 16, 17, 1000, 20000};
+const double FRACCION_REPETIDOS = 0.2;
+const size_t CONSULTAS = 300;
+const size_t KS[] = {0, 1, 5, 16, 64};
+const double RADIOS[] = {0.0, 0.05, 0.3, 5.0};
+// Tandas de insertar() del árbol dinámico; entre tanda y tanda se borra al
+// azar. Después de la de 4096 se borra en orden de inserción más de la
+// mitad de lo insertado, así que los niveles más viejos se rearman por los
+// borrados con puntos todavía vivos. Al final se vacía por cuartos.
+const size_t TANDAS[] = {1, 300, 1024, 1, 2000, 4096, 700, 5000, 3};
+const double FRACCION_BORRADOS = 0.15;
+const double FRACCION_EN_ORDEN = 0.6;
+const size_t CONSULTAS_DINAMICO = 60;
+
+// ------------------------- FUERZA BRUTA -------------------------
+double distancia2(const Point& a, const Point& b) {
+    double dx = a.x - b.x, dy = a.y - b.y, dz = a.z - b.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Distancias de los k más cercanos entre los índices de `candidatos`
+std::vector<double> knnLineal(const std::vector<Point>& pts, const std::vector<uint32_t>& candidatos,
+                              const Point& q, size_t k) {
+    std::vector<double> d;
+    for (uint32_t i : candidatos) d.push_back(distancia2(pts[i], q));
+    size_t n = std::min(k, d.size());
+    std::partial_sort(d.begin(), d.begin() + n, d.end());
+    d.resize(n);
+    return d;
+}
+
+std::vector<uint32_t> radiusLineal(const std::vector<Point>& pts, const std::vector<uint32_t>& candidatos,
+                                   const Point& q, double r) {
+    std::vector<uint32_t> dentro;
+    for (uint32_t i : candidatos)
+        if (distancia2(pts[i], q) <= r * r) dentro.push_back(i);
+    return dentro;
+}
+
+// ------------------------- COMPARACIÓN -------------------------
+size_t errores = 0;
+
+void fallo(const std::string& que) {
+    if (++errores <= 20) std::cerr << "Falla: " << que << "\n";
+}
+
+void compararKnn(const std::string& que, const std::vector<Point>& pts, const std::vector<uint32_t>& candidatos,
+                 const Point& q, size_t k, const std::vector<uint32_t>& obtenido) {
+    std::vector<double> esperado = knnLineal(pts, candidatos, q, k);
+    if (obtenido.size() != esperado.size()) {
+        fallo(que + ": " + std::to_string(obtenido.size()) + " vecinos, se esperaban " + std::to_string(esperado.size()));
+        return;
+    }
+    std::vector<uint32_t> vistos;
+    for (size_t j = 0; j < obtenido.size(); ++j) {
+        if (obtenido[j] >= pts.size() ||
+            !std::binary_search(candidatos.begin(), candidatos.end(), obtenido[j])) {
+            fallo(que + ": índice inválido " + std::to_string(obtenido[j]));
+            return;
+        }
+        if (distancia2(pts[obtenido[j]], q) != esperado[j]) {
+            fallo(que + ": el vecino " + std::to_string(j) + " no está a la distancia esperada");
+            return;
+        }
+        vistos.push_back(obtenido[j]);
+    }
+    std::sort(vistos.begin(), vistos.end());
+    if (std::adjacent_find(vistos.begin(), vistos.end()) != vistos.end()) fallo(que + ": índice repetido");
+}
+
+void compararRadius(const std::string& que, const std::vector<Point>& pts, const std::vector<uint32_t>& candidatos,
+                    const Point& q, double r, std::vector<uint32_t> obtenido) {
+    std::vector<uint32_t> esperado = radiusLineal(pts, candidatos, q, r);
+    std::sort(obtenido.begin(), obtenido.end());
+    if (obtenido != esperado)
+        fallo(que + ": " + std::to_string(obtenido.size()) + " puntos, se esperaban " + std::to_string(esperado.size()));
+}
+
+// ------------------------- DATOS -------------------------
+std::vector<Point> puntosConRepetidos(size_t n, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> u(-1.0, 1.0);
+    std::vector<Point> pts(n);
+    for (auto& p : pts) p = {u(gen), u(gen), u(gen)};
+    for (size_t i = 1; i < n; ++i)
+        if (std::uniform_real_distribution<double>(0.0, 1.0)(gen) < FRACCION_REPETIDOS) pts[i] = pts[gen() % i];
+    return pts;
+}
+
+// Puntos del conjunto, al azar en la caja y fuera de ella
+std::vector<Point> consultasPara(const std::vector<Point>& pts, std::mt19937_64& gen) {
+    std::uniform_real_distribution<double> u(-1.0, 1.0), lejos(3.0, 10.0);
+    std::vector<Point> qs;
+    for (size_t i = 0; i < CONSULTAS; ++i) {
+        switch (i % 3) {
+            case 0: qs.push_back(pts.empty() ? Point{0, 0, 0} : pts[gen() % pts.size()]); break;
+            case 1: qs.push_back({u(gen), u(gen), u(gen)}); break;
+            default: qs.push_back({lejos(gen), -lejos(gen), u(gen)}); break;
+        }
+    }
+    return qs;
+}
+
+// ------------------------- KD-TREE -------------------------
+void verificarEstatico(std::mt19937_64& gen) {
+    for (size_t n : TAMANOS) {
+        std::vector<Point> pts = puntosConRepetidos(n, gen);
+        std::vector<uint32_t> todos(n);
+        std::iota(todos.begin(), todos.end(), 0);
+        KDTree arbol;
+        arbol.build(pts);
+        std::vector<Point> qs = consultasPara(pts, gen);
+        std::string nombre = "KDTree n=" + std::to_string(n);
+
+        // k > n se prueba con n + 3
+        std::vector<size_t> ks(std::begin(KS), std::end(KS));
+        ks.push_back(n + 3);
+        for (size_t k : ks) {
+            std::vector<uint32_t> lote = arbol.knnLote(qs, k);
+            for (size_t i = 0; i < qs.size(); ++i) {
+                std::string que = nombre + " k=" + std::to_string(k) + " consulta " + std::to_string(i);
+                std::vector<uint32_t> uno = arbol.knn(qs[i], k);
+                compararKnn(que + " knn", pts, todos, qs[i], k, uno);
+                // knnLote: los mismos vecinos, completados con SIN_VECINO
+                std::vector<uint32_t> fila(lote.begin() + i * k, lote.begin() + (i + 1) * k);
+                std::vector<uint32_t> esperada = uno;
+                esperada.resize(k, KDTree::SIN_VECINO);
+                if (fila != esperada) fallo(que + " knnLote distinto de knn");
+            }
+        }
+
+        for (double r : RADIOS) {
+            std::vector<std::vector<uint32_t>> lote = arbol.radiusLote(qs, r);
+            for (size_t i = 0; i < qs.size(); ++i) {
+                std::string que = nombre + " r=" + std::to_string(r) + " consulta " + std::to_string(i);
+                compararRadius(que + " radius", pts, todos, qs[i], r, arbol.radius(qs[i], r));
+                compararRadius(que + " radiusLote", pts, todos, qs[i], r, lote[i]);
+            }
+        }
+
+        // findNearestIndex: a la distancia mínima
+        for (size_t i = 0; i < qs.size() && n > 0; ++i)
+            compararKnn(nombre + " findNearestIndex consulta " + std::to_string(i), pts, todos, qs[i], 1,
+                        {arbol.findNearestIndex(qs[i])});
+    }
+}
+
+// ------------------------- KD-TREE DINÁMICO -------------------------
+// `pts` guarda todo lo insertado por índice de inserción y `vivos` los
+// índices no borrados, ordenados.
+void consultarDinamico(const std::string& nombre, const KDTreeDinamico& arbol, const std::vector<Point>& pts,
+                       const std::vector<uint32_t>& vivos, std::mt19937_64& gen) {
+    std::vector<Point> qs = consultasPara(pts, gen);
+    qs.resize(CONSULTAS_DINAMICO);
+    for (size_t i = 0; i < qs.size(); ++i) {
+        std::string que = nombre + " consulta " + std::to_string(i);
+        for (size_t k : {size_t(1), size_t(8), vivos.size() + 2})
+            compararKnn(que + " knn k=" + std::to_string(k), pts, vivos, qs[i], k, arbol.knn(qs[i], k));
+        for (double r : RADIOS)
+            compararRadius(que + " radius r=" + std::to_string(r), pts, vivos, qs[i], r, arbol.radius(qs[i], r));
+
+        Point p = arbol.findNearest(qs[i]);
+        std::vector<double> d = knnLineal(pts, vivos, qs[i], 1);
+        if (d.empty() ? (p.x != qs[i].x || p.y != qs[i].y || p.z != qs[i].z) : distancia2(p, qs[i]) != d[0])
+            fallo(que + " findNearest no es el más cercano");
+    }
+}
+
+void verificarDinamico(std::mt19937_64& gen) {
+    KDTreeDinamico arbol;
+    std::vector<Point> pts;
+    std::vector<char> borrado;
+    size_t paso = 0;
+
+    auto vivos = [&]() {
+        std::vector<uint32_t> r;
+        for (uint32_t i = 0; i < pts.size(); ++i) if (!borrado[i]) r.push_back(i);
+        return r;
+    };
+    auto borrar = [&](uint32_t i) {
+        arbol.eliminar(i);
+        if (i < borrado.size()) borrado[i] = 1;
+    };
+
+    for (size_t tam : TANDAS) {
+        // Repetidos también contra lo ya insertado
+        std::vector<Point> nuevos = puntosConRepetidos(tam, gen);
+        for (auto& p : nuevos)
+            if (!pts.empty() && std::uniform_real_distribution<double>(0.0, 1.0)(gen) < FRACCION_REPETIDOS)
+                p = pts[gen() % pts.size()];
+        size_t inicio = pts.size();
+        arbol.insertar(nuevos);
+        pts.insert(pts.end(), nuevos.begin(), nuevos.end());
+        borrado.resize(pts.size(), 0);
+        if (arbol.size() != pts.size()) fallo("KDTreeDinamico: size() distinto de lo insertado");
+        consultarDinamico("KDTreeDinamico paso " + std::to_string(paso++) + " (insertar " + std::to_string(tam) + ")",
+                          arbol, pts, vivos(), gen);
+
+        if (tam == 4096) {
+            for (uint32_t i = 0; i < pts.size() * FRACCION_EN_ORDEN; ++i) borrar(i);
+        } else {
+            for (size_t j = 0; j < pts.size() * FRACCION_BORRADOS; ++j) borrar(gen() % pts.size());
+        }
+        // Borrar dos veces o fuera de rango no hace nada
+        borrar(inicio);
+        borrar((uint32_t)pts.size() + 10);
+        consultarDinamico("KDTreeDinamico paso " + std::to_string(paso++) + " (borrar)", arbol, pts, vivos(), gen);
+    }
+
+    // Hasta vaciarlo, consultando a cada cuarto
+    for (size_t cuarto = 1; cuarto <= 4; ++cuarto) {
+        for (uint32_t i = 0; i < pts.size() * cuarto / 4; ++i) borrar(i);
+        consultarDinamico("KDTreeDinamico vaciando " + std::to_string(cuarto) + "/4", arbol, pts, vivos(), gen);
+    }
+}
+
+// ------------------------- MAIN -------------------------
+// Uso: verificarKdTree [semilla]
+// Termina con 1 si alguna consulta no coincide con la búsqueda lineal.
+int main(int argc, char** argv) {
+    std::mt19937_64 gen(argc > 1 ? std::stoull(argv[1]) : 12345);
+
+    verificarEstatico(gen);
+    std::cout << "KDTree: " << (errores == 0 ? "ok" : "con fallas") << "\n";
+
+    size_t antes = errores;
+    verificarDinamico(gen);
+    std::cout << "KDTreeDinamico: " << (errores == antes ? "ok" : "con fallas") << "\n";
+
+    std::cout << (errores == 0 ? "Todo coincide con la búsqueda lineal\n"
+                               : std::to_string(errores) + " fallas\n");
+    return errores == 0 ? 0 : 1;
+}